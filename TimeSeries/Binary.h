@@ -0,0 +1,389 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "Exception.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace timeseries
+{
+	// read-only memory mapping of the whole file. Pages are
+	// loaded on demand and shared with other processes
+	class MappedFile
+	{
+	protected:
+		const char* data_ = nullptr;
+		size_t size_ = 0;
+#ifdef _WIN32
+		HANDLE file_ = INVALID_HANDLE_VALUE;
+		HANDLE mapping_ = nullptr;
+#endif
+	public:
+		explicit MappedFile(const std::filesystem::path& path)
+		{
+#ifdef _WIN32
+			file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file_ == INVALID_HANDLE_VALUE)
+				throw Exception("MappedFile - failed to open {}", path.string());
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file_, &size))
+			{
+				CloseHandle(file_);
+				throw Exception("MappedFile - failed to get size of {}", path.string());
+			}
+			size_ = static_cast<size_t>(size.QuadPart);
+			if (size_ == 0)
+				return;
+			mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping_ != nullptr)
+				data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+			if (data_ == nullptr)
+			{
+				if (mapping_ != nullptr)
+					CloseHandle(mapping_);
+				CloseHandle(file_);
+				throw Exception("MappedFile - failed to map {}", path.string());
+			}
+#else
+			const int file{ open(path.c_str(), O_RDONLY) };
+			if (file < 0)
+				throw Exception("MappedFile - failed to open {}", path.string());
+			struct stat status;
+			if (fstat(file, &status) != 0)
+			{
+				close(file);
+				throw Exception("MappedFile - failed to get size of {}", path.string());
+			}
+			size_ = static_cast<size_t>(status.st_size);
+			if (size_ > 0)
+			{
+				void* data{ mmap(nullptr, size_, PROT_READ, MAP_SHARED, file, 0) };
+				if (data == MAP_FAILED)
+				{
+					close(file);
+					throw Exception("MappedFile - failed to map {}", path.string());
+				}
+				data_ = static_cast<const char*>(data);
+			}
+			// mapping stays valid after the descriptor is closed
+			close(file);
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifdef _WIN32
+			if (data_ != nullptr)
+				UnmapViewOfFile(data_);
+			if (mapping_ != nullptr)
+				CloseHandle(mapping_);
+			if (file_ != INVALID_HANDLE_VALUE)
+				CloseHandle(file_);
+#else
+			if (data_ != nullptr)
+				munmap(const_cast<char*>(data_), size_);
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		inline const char* data() const { return data_; }
+		inline size_t size() const { return size_; }
+	};
+
+	// header of the binary series file. Time and value columns follow the header
+	// aligned to ColumnAlignment, so they can be used from the mapped file directly.
+	// Data is written in the byte order of the writer
+	struct BinaryHeader
+	{
+		static constexpr char Signature[8] = { 'T', 'S', 'B', 'I', 'N', 'A', 'R', 'Y' };
+		static constexpr uint32_t CurrentVersion = 1;
+		static constexpr uint32_t NativeByteOrder = 0x01020304;
+		static constexpr uint64_t ColumnAlignment = 64;
+
+		char Magic[8];
+		uint32_t Version;
+		uint32_t ByteOrder;
+		uint32_t TimeType;		// TypeCode of T
+		uint32_t ValueType;		// TypeCode of V
+		uint64_t Count;
+		uint64_t TimeOffset;	// offset of the time column from the start of the file
+		uint64_t ValueOffset;	// offset of the value column from the start of the file
+		double TimeMin;
+		double TimeMax;
+		double ValueMin;
+		double ValueMax;
+
+		// kind of the type in the high byte and size in the low byte
+		template<typename X>
+		static constexpr uint32_t TypeCode()
+		{
+			static_assert(std::is_arithmetic_v<X>, "BinaryHeader - only arithmetic types can be stored");
+			return (std::is_floating_point_v<X> ? 0x100 : std::is_signed_v<X> ? 0x200 : 0x300) | static_cast<uint32_t>(sizeof(X));
+		}
+
+		static constexpr uint64_t Align(uint64_t Offset)
+		{
+			return (Offset + ColumnAlignment - 1) / ColumnAlignment * ColumnAlignment;
+		}
+
+		// header for Count points, ranges are to be updated
+		template<typename T, typename V>
+		static BinaryHeader Make(uint64_t Count)
+		{
+			BinaryHeader header{};
+			std::memcpy(header.Magic, Signature, sizeof(Signature));
+			header.Version = CurrentVersion;
+			header.ByteOrder = NativeByteOrder;
+			header.TimeType = TypeCode<T>();
+			header.ValueType = TypeCode<V>();
+			header.Count = Count;
+			header.TimeOffset = Align(sizeof(BinaryHeader));
+			header.ValueOffset = Align(header.TimeOffset + Count * sizeof(T));
+			return header;
+		}
+
+		static void UpdateRange(double Value, bool First, double& Min, double& Max)
+		{
+			Min = First ? Value : (std::min)(Min, Value);
+			Max = First ? Value : (std::max)(Max, Value);
+		}
+	};
+
+	// time and value columns of the mapped binary file
+	template<typename T, typename V>
+	class BinaryView
+	{
+	protected:
+		std::shared_ptr<const MappedFile> file_;
+		BinaryHeader header_ = {};
+		const T* times_ = nullptr;
+		const V* values_ = nullptr;
+	public:
+		explicit BinaryView(const std::filesystem::path& path) : file_{ std::make_shared<const MappedFile>(path) }
+		{
+			if (file_->size() < sizeof(BinaryHeader))
+				throw Exception("BinaryView - {} is too short for the binary series", path.string());
+
+			std::memcpy(&header_, file_->data(), sizeof(BinaryHeader));
+			if (std::memcmp(header_.Magic, BinaryHeader::Signature, sizeof(BinaryHeader::Signature)) != 0)
+				throw Exception("BinaryView - {} is not a binary series", path.string());
+			if (header_.Version != BinaryHeader::CurrentVersion)
+				throw Exception("BinaryView - {} has unsupported version {}", path.string(), header_.Version);
+			if (header_.ByteOrder != BinaryHeader::NativeByteOrder)
+				throw Exception("BinaryView - {} has foreign byte order", path.string());
+			if (header_.TimeType != BinaryHeader::TypeCode<T>() || header_.ValueType != BinaryHeader::TypeCode<V>())
+				throw Exception("BinaryView - {} types {:#x}/{:#x} do not match {:#x}/{:#x}", path.string(),
+					header_.TimeType, header_.ValueType, BinaryHeader::TypeCode<T>(), BinaryHeader::TypeCode<V>());
+
+			const auto Fits = [this](uint64_t Offset, uint64_t Size)
+			{
+				return Offset % BinaryHeader::ColumnAlignment == 0 && Offset <= file_->size() && header_.Count <= (file_->size() - Offset) / Size;
+			};
+
+			if (!Fits(header_.TimeOffset, sizeof(T)) || !Fits(header_.ValueOffset, sizeof(V)))
+				throw Exception("BinaryView - {} is truncated or damaged", path.string());
+
+			times_ = reinterpret_cast<const T*>(file_->data() + header_.TimeOffset);
+			values_ = reinterpret_cast<const V*>(file_->data() + header_.ValueOffset);
+		}
+
+		inline const BinaryHeader& Header() const { return header_; }
+		inline size_t size() const { return static_cast<size_t>(header_.Count); }
+		inline const T* Times() const { return times_; }
+		inline const V* Values() const { return values_; }
+		// keeps the mapping alive for the storages using the columns
+		inline const std::shared_ptr<const MappedFile>& File() const { return file_; }
+
+		// checks the signature only
+		static bool Is(const std::filesystem::path& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			char magic[sizeof(BinaryHeader::Signature)];
+			return file.read(magic, sizeof(magic)) && std::memcmp(magic, BinaryHeader::Signature, sizeof(magic)) == 0;
+		}
+	};
+
+	// writes Data with Time(i)/Value(i) access to the binary series file
+	template<typename T, typename V, typename DataT>
+	void WriteBinary(const std::filesystem::path& path, const DataT& Data)
+	{
+		auto header{ BinaryHeader::Make<T, V>(Data.size()) };
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			throw Exception("WriteBinary - failed to open {}", path.string());
+
+		// columns are written by blocks, ranges are collected on the way
+		constexpr size_t BlockSize = 8192;
+		const auto WriteColumn = [&file, &Data, &header](uint64_t Offset, auto Get, double& Min, double& Max)
+		{
+			using X = std::decay_t<decltype(Get(size_t{ 0 }))>;
+			std::vector<X> block;
+			block.reserve(BlockSize);
+			file.seekp(static_cast<std::streamoff>(Offset));
+			for (size_t index = 0; index < Data.size(); index++)
+			{
+				const X value{ Get(index) };
+				BinaryHeader::UpdateRange(static_cast<double>(value), index == 0, Min, Max);
+				block.emplace_back(value);
+				if (block.size() == BlockSize || index + 1 == Data.size())
+				{
+					file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size() * sizeof(X)));
+					block.clear();
+				}
+			}
+		};
+
+		// placeholder header extends the file to the time column
+		const std::vector<char> padding(static_cast<size_t>(header.TimeOffset));
+		file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+		WriteColumn(header.TimeOffset, [&Data](size_t index) { return static_cast<T>(Data.Time(index)); }, header.TimeMin, header.TimeMax);
+		// pad the time column up to the value column
+		const auto gap{ header.ValueOffset - header.TimeOffset - header.Count * sizeof(T) };
+		file.write(padding.data(), static_cast<std::streamsize>(gap));
+		WriteColumn(header.ValueOffset, [&Data](size_t index) { return static_cast<V>(Data.Value(index)); }, header.ValueMin, header.ValueMax);
+
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+		if (!file.flush())
+			throw Exception("WriteBinary - failed to write {}", path.string());
+	}
+
+	// streaming writer of the binary series file for the data of unknown size.
+	// Times are written to the file, values are kept in the temporary file
+	// and appended to the file on Close. The temporary file is removed
+	// on the errors as well
+	template<typename T, typename V>
+	class BinaryWriterT
+	{
+	protected:
+		// removes the file when the writer is destroyed, the streams
+		// declared after it are closed before
+		struct TemporaryPath
+		{
+			std::filesystem::path Path;
+			~TemporaryPath()
+			{
+				std::error_code error;
+				std::filesystem::remove(Path, error);
+			}
+		};
+
+		std::filesystem::path path_;
+		TemporaryPath valuespath_;
+		std::ofstream file_;
+		std::ofstream values_;
+		std::vector<T> timeblock_;
+		std::vector<V> valueblock_;
+		BinaryHeader header_;
+
+		void FlushBlocks()
+		{
+			file_.write(reinterpret_cast<const char*>(timeblock_.data()), static_cast<std::streamsize>(timeblock_.size() * sizeof(T)));
+			values_.write(reinterpret_cast<const char*>(valueblock_.data()), static_cast<std::streamsize>(valueblock_.size() * sizeof(V)));
+			timeblock_.clear();
+			valueblock_.clear();
+			if (!file_ || !values_)
+				throw Exception("BinaryWriterT - failed to write {}", path_.string());
+		}
+	public:
+		static constexpr size_t BlockSize = 8192;
+
+		explicit BinaryWriterT(const std::filesystem::path& path) :
+			path_{ path },
+			valuespath_{ std::filesystem::path(path).concat(".values") },
+			file_{ path, std::ios::binary | std::ios::trunc },
+			values_{ valuespath_.Path, std::ios::binary | std::ios::trunc },
+			header_{ BinaryHeader::Make<T, V>(0) }
+		{
+			if (!file_.is_open() || !values_.is_open())
+				throw Exception("BinaryWriterT - failed to open {}", path_.string());
+			// placeholder header extends the file to the time column
+			const std::vector<char> padding(static_cast<size_t>(header_.TimeOffset));
+			file_.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+			timeblock_.reserve(BlockSize);
+			valueblock_.reserve(BlockSize);
+		}
+
+		~BinaryWriterT()
+		{
+			try
+			{
+				if (file_.is_open())
+					Close();
+			}
+			catch (...) {}
+		}
+
+		void Write(const T& Time, const V& Value)
+		{
+			const bool first{ header_.Count == 0 };
+			BinaryHeader::UpdateRange(static_cast<double>(Time), first, header_.TimeMin, header_.TimeMax);
+			BinaryHeader::UpdateRange(static_cast<double>(Value), first, header_.ValueMin, header_.ValueMax);
+			header_.Count++;
+			timeblock_.emplace_back(Time);
+			valueblock_.emplace_back(Value);
+			if (timeblock_.size() == BlockSize)
+				FlushBlocks();
+		}
+
+		void Close()
+		{
+			FlushBlocks();
+			values_.close();
+
+			const auto ranges{ header_ };
+			header_ = BinaryHeader::Make<T, V>(ranges.Count);
+			header_.TimeMin = ranges.TimeMin;
+			header_.TimeMax = ranges.TimeMax;
+			header_.ValueMin = ranges.ValueMin;
+			header_.ValueMax = ranges.ValueMax;
+
+			// pad the time column up to the value column and append the values
+			std::vector<char> buffer(1 << 20);
+			const auto gap{ header_.ValueOffset - header_.TimeOffset - header_.Count * sizeof(T) };
+			file_.write(buffer.data(), static_cast<std::streamsize>(gap));
+			std::ifstream values(valuespath_.Path, std::ios::binary);
+			uint64_t copied{ 0 };
+			while (values.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || values.gcount() > 0)
+			{
+				file_.write(buffer.data(), values.gcount());
+				copied += static_cast<uint64_t>(values.gcount());
+			}
+			const bool complete{ values.is_open() && copied == header_.Count * sizeof(V) };
+			values.close();
+			std::error_code ec;
+			std::filesystem::remove(valuespath_.Path, ec);
+			if (!complete)
+			{
+				// the header is not written, so the file is not recognized as the binary series
+				file_.close();
+				throw Exception("BinaryWriterT - failed to read values {} of {}", valuespath_.Path.string(), path_.string());
+			}
+
+			file_.seekp(0);
+			file_.write(reinterpret_cast<const char*>(&header_), sizeof(BinaryHeader));
+			file_.close();
+			if (!file_)
+				throw Exception("BinaryWriterT - failed to write {}", path_.string());
+		}
+	};
+}
@@ -0,0 +1,542 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "fmt/format.h"
+#include "Exception.h"
+#include "ThreadPool.h"
+
+namespace timeseries
+{
+	// projection of value columns: for each column of the file
+	// position in the output or Skip if the column is not requested.
+	// Each column can be requested once
+	class CSVColumns
+	{
+	protected:
+		std::vector<size_t> Positions_;
+	public:
+		static constexpr size_t Skip = (std::numeric_limits<size_t>::max)();
+
+		CSVColumns(const std::vector<size_t>& Columns)
+		{
+			if (Columns.empty())
+				return;
+
+			Positions_.resize(*std::max_element(Columns.begin(), Columns.end()) + 1, Skip);
+			for (size_t position = 0; position < Columns.size(); position++)
+			{
+				if (Positions_[Columns[position]] != Skip)
+					throw Exception("CSVColumns - column {} is requested twice", Columns[position]);
+				Positions_[Columns[position]] = position;
+			}
+		}
+
+		// count of the columns to be scanned in the line
+		inline size_t size() const { return Positions_.size(); }
+		inline size_t Position(size_t Column) const { return Positions_[Column]; }
+	};
+
+	// decision on the record by its time
+	enum class CSVRecord
+	{
+		Take,	// parse the value and pass the record
+		Skip,	// skip the record without value conversion
+		Stop	// stop parsing
+	};
+
+	// locale-free parser for "time;value" records. Numbers are
+	// converted with std::from_chars and may use both ',' and '.'
+	// as a decimal separator
+	class CSVParser
+	{
+	protected:
+		static inline bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+		}
+
+		static inline bool IsBlank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+		}
+
+		static inline bool IsNumberChar(char c)
+		{
+			return (c >= '0' && c <= '9') || c == '.' || c == ',' || c == '-' || c == '+' || c == 'e' || c == 'E';
+		}
+
+	public:
+		// parses number from [first, last) and returns pointer to the first
+		// character after the number or nullptr if there is no number
+		template<typename V>
+		static const char* ParseNumber(const char* first, const char* last, V& value)
+		{
+			// from_chars does not accept explicit plus sign
+			if (first < last && *first == '+')
+				first++;
+
+			{
+				const auto [ptr, ec] { std::from_chars(first, last, value) };
+				if (ec != std::errc())
+					return nullptr;
+				if (ptr == last || *ptr != ',')
+					return ptr;
+			}
+
+			// number with decimal comma - replace comma with point
+			// in a local copy to make it acceptable by from_chars
+			char local[64];
+			size_t length{ 0 };
+			auto end{ first };
+			for (; end < last && IsNumberChar(*end); end++, length++)
+				if (length < sizeof(local))
+					local[length] = *end == ',' ? '.' : *end;
+
+			std::string longnumber;
+			const char* buffer{ local };
+			if (length > sizeof(local))
+			{
+				longnumber.assign(first, end);
+				std::replace(longnumber.begin(), longnumber.end(), ',', '.');
+				buffer = longnumber.data();
+			}
+
+			const auto [ptr, ec] { std::from_chars(buffer, buffer + length, value) };
+			return ec == std::errc() ? first + (ptr - buffer) : nullptr;
+		}
+
+		// parses records from [first, last) and calls Record(time, value) for each of them.
+		// The rest of each line after the value is ignored. Returns false
+		// if parsing stopped on malformed record
+		template<typename T, typename V, typename Fn>
+		static bool Parse(const char* first, const char* last, Fn&& Record)
+		{
+			return Parse<T, V>(first, last, [](const T&) { return CSVRecord::Take; }, Record);
+		}
+
+		// parses records as above, Filter(time) decides what to do with the record.
+		// Returns false if parsing stopped on malformed record or by the Filter
+		template<typename T, typename V, typename FilterFn, typename Fn>
+		static bool Parse(const char* first, const char* last, FilterFn&& Filter, Fn&& Record)
+		{
+			auto p{ first };
+			for (;;)
+			{
+				while (p < last && IsSpace(*p))
+					p++;
+				if (p == last)
+					return true;
+
+				T time{};
+				V value{};
+				if (p = ParseNumber(p, last, time); p == nullptr)
+					return false;
+
+				if (const auto decision{ Filter(time) }; decision != CSVRecord::Take)
+				{
+					if (decision == CSVRecord::Stop)
+						return false;
+					while (p < last && *p != '\n')
+						p++;
+					continue;
+				}
+
+				// any single non blank character separates time and value
+				while (p < last && IsBlank(*p))
+					p++;
+				if (p == last || *p == '\n')
+					return false;
+				p++;
+				while (p < last && IsSpace(*p))
+					p++;
+				if (p = ParseNumber(p, last, value); p == nullptr)
+					return false;
+
+				Record(time, value);
+
+				while (p < last && *p != '\n')
+					p++;
+			}
+		}
+
+		// splits the line to the names of the value columns if it is a header
+		static std::vector<std::string> Header(const char* first, const char* last)
+		{
+			std::vector<std::string> names;
+			while (first < last && IsSpace(*first))
+				first++;
+			double time{};
+			if (first == last || ParseNumber(first, last, time) != nullptr)
+				return names;
+
+			// skip the time column name
+			while (first < last && *first != ';')
+				first++;
+			while (first < last)
+			{
+				first++;
+				auto name{ first };
+				while (first < last && *first != ';')
+					first++;
+				auto end{ first };
+				while (name < end && IsSpace(*name))
+					name++;
+				while (end > name && IsSpace(*(end - 1)))
+					end--;
+				names.emplace_back(name, end);
+			}
+			return names;
+		}
+
+		// parses "time;c1;c2;...;cN" lines from [first, last) and calls Record(time, Values) with the values
+		// of the columns requested placed to Values. Columns not requested are skipped without conversion
+		template<typename T, typename V, typename Fn>
+		static bool ParseColumns(const char* first, const char* last, const CSVColumns& Columns, V* Values, Fn&& Record)
+		{
+			auto p{ first };
+			for (;;)
+			{
+				while (p < last && IsSpace(*p))
+					p++;
+				if (p == last)
+					return true;
+
+				T time{};
+				if (p = ParseNumber(p, last, time); p == nullptr)
+					return false;
+
+				for (size_t column = 0; column < Columns.size(); column++)
+				{
+					while (p < last && IsBlank(*p))
+						p++;
+					if (p == last || *p != ';')
+						return false;
+					p++;
+
+					if (const auto position{ Columns.Position(column) }; position != CSVColumns::Skip)
+					{
+						while (p < last && IsBlank(*p))
+							p++;
+						if (p = ParseNumber(p, last, Values[position]); p == nullptr)
+							return false;
+					}
+					else
+						while (p < last && *p != ';' && *p != '\n')
+							p++;
+				}
+
+				Record(time, static_cast<const V*>(Values));
+
+				while (p < last && *p != '\n')
+					p++;
+			}
+		}
+	};
+
+	// buffered "time;value" writer. Numbers are formatted with fmt to the large
+	// buffer which is written to the file by blocks. By default the numbers
+	// are written in the shortest form which reads back to the same value
+	class CSVWriter
+	{
+	protected:
+		std::filesystem::path path_;
+		std::ofstream file_;
+		fmt::memory_buffer buffer_;
+		char Decimal_;
+		int Precision_;
+
+		template<typename X>
+		void Number(const X& Value)
+		{
+			const auto start{ buffer_.size() };
+			if (Precision_ == Shortest || !std::is_floating_point_v<X>)
+				fmt::format_to(buffer_, "{}", Value);
+			else
+				fmt::format_to(buffer_, "{:.{}g}", Value, Precision_);
+
+			if (Decimal_ != '.')
+				std::replace(buffer_.data() + start, buffer_.data() + buffer_.size(), '.', Decimal_);
+		}
+	public:
+		static constexpr size_t BlockSize = 1 << 20;
+		static constexpr int Shortest = -1;
+
+		// Precision is the count of significant digits or Shortest
+		CSVWriter(const std::filesystem::path& path, char Decimal = ',', int Precision = Shortest) :
+			path_{ path },
+			file_{ path, std::ios::binary | std::ios::trunc },
+			Decimal_{ Decimal },
+			Precision_{ Precision }
+		{
+			if (!file_.is_open())
+				throw Exception("CSVWriter - failed to open {}", path_.string());
+			buffer_.reserve(BlockSize + 128);
+		}
+
+		// the data left is written, but errors can be reported by Close() only
+		~CSVWriter()
+		{
+			try
+			{
+				if (file_.is_open())
+					Close();
+			}
+			catch (...) {}
+		}
+
+		template<typename T, typename V>
+		void Write(const T& Time, const V& Value)
+		{
+			Number(Time);
+			buffer_.push_back(';');
+			Number(Value);
+			buffer_.push_back('\n');
+			if (buffer_.size() >= BlockSize)
+				Flush();
+		}
+
+		void Flush()
+		{
+			file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+			buffer_.clear();
+			if (!file_)
+				throw Exception("CSVWriter - failed to write {}", path_.string());
+		}
+
+		void Close()
+		{
+			Flush();
+			file_.close();
+			if (!file_)
+				throw Exception("CSVWriter - failed to close {}", path_.string());
+		}
+	};
+
+	// part of the file parsed in parallel
+	template<typename T, typename V>
+	struct CSVChunk
+	{
+		std::vector<T> Times;
+		std::vector<V> Values;
+		bool Complete = true;	// false if parsing stopped on malformed record
+	};
+
+	// pulls blocks of complete lines from the CSV file. Decimal commas
+	// are replaced with points in the block returned
+	class CSVBlocks
+	{
+	protected:
+		std::ifstream csvfile_;
+		std::vector<char> buffer_;
+		size_t end_ = 0;			// end of the block returned
+		size_t available_ = 0;		// end of the data read
+		bool done_ = false;
+	public:
+		// blocks start from the line at Offset
+		CSVBlocks(const std::filesystem::path& path, size_t BlockSize, uint64_t Offset = 0) :
+			csvfile_{ path, std::ios::binary },
+			buffer_((std::max)(BlockSize, static_cast<size_t>(1)))
+		{
+			if (!csvfile_.is_open())
+				throw Exception("CSVReader::Read - failed to open {}", path.string());
+			if (Offset > 0)
+				csvfile_.seekg(static_cast<std::streamoff>(Offset));
+		}
+
+		// returns the next block in [First, Last) or false if the file is over
+		bool Next(const char*& First, const char*& Last)
+		{
+			if (done_)
+				return false;
+
+			// incomplete line carried from the previous block
+			std::copy(buffer_.begin() + end_, buffer_.begin() + available_, buffer_.begin());
+			size_t tail{ available_ - end_ };
+			for (;;)
+			{
+				// the line does not fit in the buffer - grow it
+				if (tail == buffer_.size())
+					buffer_.resize(2 * buffer_.size());
+
+				csvfile_.read(buffer_.data() + tail, static_cast<std::streamsize>(buffer_.size() - tail));
+				available_ = tail + static_cast<size_t>(csvfile_.gcount());
+				done_ = csvfile_.eof() || csvfile_.gcount() == 0;
+				const auto begin{ buffer_.data() };
+				auto end{ begin + available_ };
+
+				if (!done_)
+				{
+					// return complete lines only
+					auto newline{ end };
+					while (newline > begin && *(newline - 1) != '\n')
+						newline--;
+					if (newline == begin)
+					{
+						tail = available_;
+						continue;
+					}
+					end = newline;
+				}
+
+				// comma is never a field separator, so the whole block can be
+				// switched to the decimal point in one pass
+				for (auto p{ begin }; p < end; p++)
+					if (*p == ',')
+						*p = '.';
+
+				end_ = static_cast<size_t>(end - begin);
+				First = begin;
+				Last = end;
+				return true;
+			}
+		}
+	};
+
+	// reads CSV file by large blocks and feeds complete lines to CSVParser
+	class CSVReader
+	{
+	protected:
+		std::filesystem::path path_;
+		size_t BlockSize_;
+	public:
+		static constexpr size_t DefaultBlockSize = 1 << 20;
+		// files are not split to the chunks less than this size
+		static constexpr size_t MinChunkSize = 1 << 16;
+
+		CSVReader(const std::filesystem::path& path, size_t BlockSize = DefaultBlockSize) :
+			path_{ path },
+			BlockSize_{ (std::max)(BlockSize, static_cast<size_t>(1)) } {}
+
+		// reads the file from the line at Offset by blocks of complete lines and
+		// calls Block(first, last) for them. Reading stops if Block returns false
+		template<typename Fn>
+		void ReadBlocks(Fn&& Block, uint64_t Offset = 0) const
+		{
+			CSVBlocks blocks(path_, BlockSize_, Offset);
+			const char* first{ nullptr };
+			const char* last{ nullptr };
+			while (blocks.Next(first, last))
+				if (!Block(first, last))
+					break;
+		}
+
+		template<typename T, typename V, typename Fn>
+		void Read(Fn&& Record) const
+		{
+			ReadBlocks([&Record](const char* first, const char* last)
+				{
+					return CSVParser::Parse<T, V>(first, last, Record);
+				});
+		}
+
+		// reads records from the line at Offset passed by Filter(time),
+		// reading stops if Filter returns CSVRecord::Stop
+		template<typename T, typename V, typename FilterFn, typename Fn>
+		void Read(FilterFn&& Filter, Fn&& Record, uint64_t Offset = 0) const
+		{
+			ReadBlocks([&Filter, &Record](const char* first, const char* last)
+				{
+					return CSVParser::Parse<T, V>(first, last, Filter, Record);
+				}, Offset);
+		}
+
+		// reads the whole file, splits it at line boundaries to Chunks parts and
+		// parses them in parallel. Chunks are returned in the order of the file
+		template<typename T, typename V>
+		std::vector<CSVChunk<T, V>> ReadChunks(size_t Chunks, ThreadPool& Pool = ThreadPool::Default()) const
+		{
+			std::ifstream csvfile(path_, std::ios::binary | std::ios::ate);
+			if (!csvfile.is_open())
+				throw Exception("CSVReader::ReadChunks - failed to open {}", path_.string());
+
+			std::vector<char> buffer(static_cast<size_t>(csvfile.tellg()));
+			csvfile.seekg(0);
+			csvfile.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			buffer.resize(static_cast<size_t>(csvfile.gcount()));
+
+			Chunks = (std::max)(static_cast<size_t>(1), (std::min)(Chunks, buffer.size() / MinChunkSize));
+
+			// chunks start after the line end nearest to the equal split
+			std::vector<size_t> bounds(Chunks + 1, buffer.size());
+			bounds.front() = 0;
+			for (size_t chunk = 1; chunk < Chunks; chunk++)
+			{
+				auto bound{ (std::max)(buffer.size() * chunk / Chunks, bounds[chunk - 1]) };
+				while (bound < buffer.size() && buffer[bound - 1] != '\n')
+					bound++;
+				bounds[chunk] = bound;
+			}
+
+			std::vector<CSVChunk<T, V>> chunks(Chunks);
+			Pool.ParallelFor(Chunks, [&buffer, &bounds, &chunks](size_t chunk)
+				{
+					const auto begin{ buffer.data() + bounds[chunk] }, end{ buffer.data() + bounds[chunk + 1] };
+					for (auto p{ begin }; p < end; p++)
+						if (*p == ',')
+							*p = '.';
+
+					auto& parsed{ chunks[chunk] };
+					parsed.Complete = CSVParser::Parse<T, V>(begin, end, [&parsed](const T& time, const V& value)
+						{
+							parsed.Times.emplace_back(time);
+							parsed.Values.emplace_back(value);
+						});
+				});
+			return chunks;
+		}
+
+		// returns names of the value columns if the first line of the file is a header.
+		// Header is the first line which does not start from a number
+		std::vector<std::string> Header() const
+		{
+			std::ifstream csvfile(path_, std::ios::binary);
+			if (!csvfile.is_open())
+				throw Exception("CSVReader::Header - failed to open {}", path_.string());
+
+			std::string line;
+			std::getline(csvfile, line);
+			return CSVParser::Header(line.data(), line.data() + line.size());
+		}
+
+		// finds indexes of value columns by names from the header
+		std::vector<size_t> Columns(const std::vector<std::string>& Names) const
+		{
+			const auto header{ Header() };
+			std::vector<size_t> columns;
+			for (const auto& name : Names)
+			{
+				const auto column{ std::find(header.begin(), header.end(), name) };
+				if (column == header.end())
+					throw Exception("CSVReader::Columns - column \"{}\" not found in {}", name, path_.string());
+				columns.push_back(static_cast<size_t>(column - header.begin()));
+			}
+			return columns;
+		}
+
+		// reads "time;c1;c2;...;cN" file with optional header and calls Record(time, values)
+		// with the values of Columns requested in the order of Columns
+		template<typename T, typename V, typename Fn>
+		void ReadColumns(const std::vector<size_t>& Columns, Fn&& Record) const
+		{
+			const CSVColumns columns(Columns);
+			std::vector<V> values(Columns.size());
+			bool header{ !Header().empty() };
+			ReadBlocks([&](const char* first, const char* last)
+				{
+					if (header)
+					{
+						header = false;
+						while (first < last && *first++ != '\n');
+					}
+					return CSVParser::ParseColumns<T, V>(first, last, columns, values.data(), Record);
+				});
+		}
+	};
+}
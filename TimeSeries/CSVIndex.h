@@ -0,0 +1,195 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Exception.h"
+#include "CSV.h"
+#include "Binary.h"
+
+namespace timeseries
+{
+	// header of the sidecar index file
+	struct CSVIndexHeader
+	{
+		static constexpr char Signature[8] = { 'T', 'S', 'C', 'S', 'V', 'I', 'D', 'X' };
+		static constexpr uint32_t CurrentVersion = 1;
+
+		char Magic[8];
+		uint32_t Version;
+		uint32_t ByteOrder;		// BinaryHeader::NativeByteOrder of the writer
+		uint32_t TimeType;		// BinaryHeader::TypeCode of T
+		uint32_t ValueType;		// BinaryHeader::TypeCode of V
+		uint64_t Stride;
+		uint64_t FileSize;		// size and modification time of the CSV file indexed
+		int64_t FileTime;
+		uint64_t Count;
+	};
+
+	// sidecar index of the "time;value" CSV file: byte offset and time of every Stride-th
+	// record and the range of values of the Stride records starting there. The index is
+	// stale if the CSV file has changed since the index was built
+	template<typename T, typename V>
+	class CSVIndexT
+	{
+	public:
+		struct Entry
+		{
+			uint64_t Offset = 0;	// offset of the line of the first record of the block
+			T Time = {};			// time of the first record of the block
+			V Min = {};
+			V Max = {};
+		};
+	protected:
+		std::vector<Entry> entries_;
+		uint64_t Stride_ = DefaultStride;
+		uint64_t FileSize_ = 0;
+		int64_t FileTime_ = 0;
+
+		static std::pair<uint64_t, int64_t> Stamp(const std::filesystem::path& path)
+		{
+			return { static_cast<uint64_t>(std::filesystem::file_size(path)),
+					 static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count()) };
+		}
+
+		// first block with the time not less than Time
+		size_t Block(const T& Time) const
+		{
+			return std::lower_bound(entries_.begin(), entries_.end(), Time, [](const Entry& lhs, const T& rhs)
+				{
+					return lhs.Time < rhs;
+				}) - entries_.begin();
+		}
+	public:
+		static constexpr size_t DefaultStride = 1024;
+
+		// sidecar index file of the CSV file
+		static std::filesystem::path SidecarPath(const std::filesystem::path& path)
+		{
+			return std::filesystem::path(path).concat(".tsidx");
+		}
+
+		// parses the whole CSV file and builds the index
+		static CSVIndexT Build(const std::filesystem::path& path, size_t Stride = DefaultStride)
+		{
+			CSVIndexT index;
+			index.Stride_ = (std::max)(Stride, static_cast<size_t>(1));
+			std::tie(index.FileSize_, index.FileTime_) = Stamp(path);
+
+			CSVBlocks blocks(path, CSVReader::DefaultBlockSize);
+			const char* first{ nullptr };
+			const char* last{ nullptr };
+			uint64_t offset{ 0 };	// offset of the block in the file
+			uint64_t record{ 0 };
+			bool complete{ true };
+			while (complete && blocks.Next(first, last))
+			{
+				// records are parsed line by line to know their offsets
+				for (auto line{ first }; complete && line < last;)
+				{
+					auto end{ std::find(line, last, '\n') };
+					if (end != last)
+						end++;
+					complete = CSVParser::Parse<T, V>(line, end, [&](const T& time, const V& value)
+						{
+							if (record++ % index.Stride_ == 0)
+								index.entries_.push_back({ offset + static_cast<uint64_t>(line - first), time, value, value });
+							else
+							{
+								auto& entry{ index.entries_.back() };
+								entry.Min = (std::min)(entry.Min, value);
+								entry.Max = (std::max)(entry.Max, value);
+							}
+						});
+					line = end;
+				}
+				offset += static_cast<uint64_t>(last - first);
+			}
+			return index;
+		}
+
+		void Write(const std::filesystem::path& path) const
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+				throw Exception("CSVIndexT::Write - failed to open {}", path.string());
+
+			CSVIndexHeader header{};
+			std::memcpy(header.Magic, CSVIndexHeader::Signature, sizeof(CSVIndexHeader::Signature));
+			header.Version = CSVIndexHeader::CurrentVersion;
+			header.ByteOrder = BinaryHeader::NativeByteOrder;
+			header.TimeType = BinaryHeader::TypeCode<T>();
+			header.ValueType = BinaryHeader::TypeCode<V>();
+			header.Stride = Stride_;
+			header.FileSize = FileSize_;
+			header.FileTime = FileTime_;
+			header.Count = entries_.size();
+			file.write(reinterpret_cast<const char*>(&header), sizeof(CSVIndexHeader));
+			file.write(reinterpret_cast<const char*>(entries_.data()), static_cast<std::streamsize>(entries_.size() * sizeof(Entry)));
+			if (!file.flush())
+				throw Exception("CSVIndexT::Write - failed to write {}", path.string());
+		}
+
+		// builds the index and writes it to the sidecar file
+		static CSVIndexT Create(const std::filesystem::path& path, size_t Stride = DefaultStride)
+		{
+			auto index{ Build(path, Stride) };
+			index.Write(SidecarPath(path));
+			return index;
+		}
+
+		// reads the sidecar index of the CSV file if it exists and is up to date
+		static std::optional<CSVIndexT> Load(const std::filesystem::path& path)
+		{
+			std::ifstream file(SidecarPath(path), std::ios::binary);
+			CSVIndexHeader header{};
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(CSVIndexHeader)) ||
+				std::memcmp(header.Magic, CSVIndexHeader::Signature, sizeof(CSVIndexHeader::Signature)) != 0 ||
+				header.Version != CSVIndexHeader::CurrentVersion ||
+				header.ByteOrder != BinaryHeader::NativeByteOrder ||
+				header.TimeType != BinaryHeader::TypeCode<T>() ||
+				header.ValueType != BinaryHeader::TypeCode<V>() ||
+				std::make_pair(header.FileSize, header.FileTime) != Stamp(path))
+				return {};
+
+			CSVIndexT index;
+			index.Stride_ = header.Stride;
+			index.FileSize_ = header.FileSize;
+			index.FileTime_ = header.FileTime;
+			index.entries_.resize(static_cast<size_t>(header.Count));
+			if (!file.read(reinterpret_cast<char*>(index.entries_.data()), static_cast<std::streamsize>(index.entries_.size() * sizeof(Entry))))
+				return {};
+			return index;
+		}
+
+		inline const std::vector<Entry>& Entries() const { return entries_; }
+		inline size_t Stride() const { return static_cast<size_t>(Stride_); }
+
+		// offset of the block to read from to get all the records from
+		// Time and at least Records records before Time if there are any
+		uint64_t Seek(const T& Time, size_t Records = 1) const
+		{
+			const auto back{ 1 + ((std::max)(Records, static_cast<size_t>(1)) - 1 + Stride_ - 1) / Stride_ };
+			const auto block{ Block(Time) };
+			return block < back ? 0 : entries_[block - back].Offset;
+		}
+
+		// range of values of the blocks with records from Begin to End.
+		// The range is conservative as the blocks are taken whole
+		std::optional<std::pair<V, V>> ValueBounds(const T& Begin, const T& End) const
+		{
+			std::optional<std::pair<V, V>> bounds;
+			for (size_t block = (std::max)(Block(Begin), static_cast<size_t>(1)) - 1; block < entries_.size() && !(End < entries_[block].Time); block++)
+				if (bounds.has_value())
+					bounds = std::make_pair((std::min)(bounds->first, entries_[block].Min), (std::max)(bounds->second, entries_[block].Max));
+				else
+					bounds = std::make_pair(entries_[block].Min, entries_[block].Max);
+			return bounds;
+		}
+	};
+}
@@ -0,0 +1,231 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#define TIMESERIES_COMPARE_SSE2
+#endif
+
+namespace timeseries
+{
+	// vectorized passes over the block of aligned pairs for CompareResultT. Run computes
+	// differences, absolute weighted differences |v1 - v2| / (Rtol * |max(v1, v2)| + Atol),
+	// the sum of squares of the differences and the extremes of the weighted differences.
+	// Prefix computes the extremes of the running sum of the differences. Sums are split
+	// to Lanes the same way whatever the instruction set is, so AVX2, SSE2 and the scalar
+	// code give the same result
+	template<typename V>
+	class CompareKernelT
+	{
+	public:
+		static constexpr size_t Lanes = 4;
+
+		struct Result
+		{
+			V Square;	// sum of squares of the differences
+			V High;		// max of the weighted differences as the strict scan finds it
+			V Low;		// min of the weighted differences
+		};
+
+		struct PrefixResult
+		{
+			V Sum;		// sum of the differences
+			V High;		// max of the running sum
+			V Low;		// min of the running sum
+		};
+	protected:
+		struct LanesT
+		{
+			V Squares[Lanes] = {};
+			V Highs[Lanes];
+			V Lows[Lanes];
+		};
+
+		// running sums of the quarters of the block
+		struct QuartersT
+		{
+			V Sums[Lanes] = {};
+			V Highs[Lanes];
+			V Lows[Lanes];
+		};
+
+#ifdef TIMESERIES_COMPARE_SSE2
+		// processes whole groups of Lanes pairs of doubles, returns count of the pairs processed
+		static size_t Vectorized(const double* Values1, const double* Values2, size_t Count, double Rtol, double Atol,
+			double* Diff, double* Awd, LanesT& State)
+		{
+			const size_t whole{ Count - Count % Lanes };
+#ifdef __AVX2__
+			const __m256d sign{ _mm256_set1_pd(-0.0) }, rtol{ _mm256_set1_pd(Rtol) }, atol{ _mm256_set1_pd(Atol) };
+			__m256d squares{ _mm256_loadu_pd(State.Squares) }, highs{ _mm256_loadu_pd(State.Highs) }, lows{ _mm256_loadu_pd(State.Lows) };
+			for (size_t index = 0; index < whole; index += Lanes)
+			{
+				const __m256d v1{ _mm256_loadu_pd(Values1 + index) }, v2{ _mm256_loadu_pd(Values2 + index) };
+				const __m256d diff{ _mm256_sub_pd(v1, v2) };
+				// max(v2, v1) keeps v1 for NaN and equal values as std::max(v1, v2) does
+				const __m256d weight{ _mm256_add_pd(_mm256_mul_pd(rtol, _mm256_andnot_pd(sign, _mm256_max_pd(v2, v1))), atol) };
+				const __m256d awd{ _mm256_andnot_pd(sign, _mm256_div_pd(diff, weight)) };
+				_mm256_storeu_pd(Diff + index, diff);
+				_mm256_storeu_pd(Awd + index, awd);
+				squares = _mm256_add_pd(squares, _mm256_mul_pd(diff, diff));
+				// the lane is kept for NaN as the strict comparison keeps it
+				highs = _mm256_max_pd(awd, highs);
+				lows = _mm256_min_pd(awd, lows);
+			}
+			_mm256_storeu_pd(State.Squares, squares);
+			_mm256_storeu_pd(State.Highs, highs);
+			_mm256_storeu_pd(State.Lows, lows);
+#else
+			const __m128d sign{ _mm_set1_pd(-0.0) }, rtol{ _mm_set1_pd(Rtol) }, atol{ _mm_set1_pd(Atol) };
+			// lanes 0, 1 and 2, 3 of the group in two registers
+			__m128d squares[2], highs[2], lows[2];
+			for (size_t half = 0; half < 2; half++)
+			{
+				squares[half] = _mm_loadu_pd(State.Squares + 2 * half);
+				highs[half] = _mm_loadu_pd(State.Highs + 2 * half);
+				lows[half] = _mm_loadu_pd(State.Lows + 2 * half);
+			}
+			for (size_t index = 0; index < whole; index += Lanes)
+				for (size_t half = 0; half < 2; half++)
+				{
+					const size_t pair{ index + 2 * half };
+					const __m128d v1{ _mm_loadu_pd(Values1 + pair) }, v2{ _mm_loadu_pd(Values2 + pair) };
+					const __m128d diff{ _mm_sub_pd(v1, v2) };
+					const __m128d weight{ _mm_add_pd(_mm_mul_pd(rtol, _mm_andnot_pd(sign, _mm_max_pd(v2, v1))), atol) };
+					const __m128d awd{ _mm_andnot_pd(sign, _mm_div_pd(diff, weight)) };
+					_mm_storeu_pd(Diff + pair, diff);
+					_mm_storeu_pd(Awd + pair, awd);
+					squares[half] = _mm_add_pd(squares[half], _mm_mul_pd(diff, diff));
+					highs[half] = _mm_max_pd(awd, highs[half]);
+					lows[half] = _mm_min_pd(awd, lows[half]);
+				}
+			for (size_t half = 0; half < 2; half++)
+			{
+				_mm_storeu_pd(State.Squares + 2 * half, squares[half]);
+				_mm_storeu_pd(State.Highs + 2 * half, highs[half]);
+				_mm_storeu_pd(State.Lows + 2 * half, lows[half]);
+			}
+#endif
+			return whole;
+		}
+
+		// running sums of the quarters of Quarter differences, the lane of the quarter is
+		// taken from the place of the quarter in the block
+		static void VectorizedPrefix(const double* Diff, size_t Quarter, QuartersT& State)
+		{
+			__m128d sums[2], highs[2], lows[2];
+			for (size_t half = 0; half < 2; half++)
+			{
+				sums[half] = _mm_loadu_pd(State.Sums + 2 * half);
+				highs[half] = _mm_loadu_pd(State.Highs + 2 * half);
+				lows[half] = _mm_loadu_pd(State.Lows + 2 * half);
+			}
+			for (size_t index = 0; index < Quarter; index++)
+				for (size_t half = 0; half < 2; half++)
+				{
+					const double* diff{ Diff + 2 * half * Quarter + index };
+					sums[half] = _mm_add_pd(sums[half], _mm_set_pd(diff[Quarter], diff[0]));
+					highs[half] = _mm_max_pd(sums[half], highs[half]);
+					lows[half] = _mm_min_pd(sums[half], lows[half]);
+				}
+			for (size_t half = 0; half < 2; half++)
+			{
+				_mm_storeu_pd(State.Sums + 2 * half, sums[half]);
+				_mm_storeu_pd(State.Highs + 2 * half, highs[half]);
+				_mm_storeu_pd(State.Lows + 2 * half, lows[half]);
+			}
+		}
+#endif
+	public:
+		// fills Diff and Awd for Count > 0 pairs
+		static Result Run(const V* Values1, const V* Values2, size_t Count, V Rtol, V Atol, V* Diff, V* Awd)
+		{
+			const auto Weighted = [&](size_t index)
+			{
+				Diff[index] = Values1[index] - Values2[index];
+				Awd[index] = std::abs(Diff[index] / (Rtol * std::abs((std::max)(Values1[index], Values2[index])) + Atol));
+			};
+
+			LanesT state;
+			Weighted(0);
+			std::fill(state.Highs, state.Highs + Lanes, Awd[0]);
+			std::fill(state.Lows, state.Lows + Lanes, Awd[0]);
+
+			const size_t whole{ Count - Count % Lanes };
+			size_t index{ 0 };
+#ifdef TIMESERIES_COMPARE_SSE2
+			if constexpr (std::is_same_v<V, double>)
+				index = Vectorized(Values1, Values2, Count, Rtol, Atol, Diff, Awd, state);
+#endif
+			for (; index < whole; index += Lanes)
+				for (size_t lane = 0; lane < Lanes; lane++)
+				{
+					Weighted(index + lane);
+					state.Squares[lane] += Diff[index + lane] * Diff[index + lane];
+					state.Highs[lane] = state.Highs[lane] < Awd[index + lane] ? Awd[index + lane] : state.Highs[lane];
+					state.Lows[lane] = state.Lows[lane] > Awd[index + lane] ? Awd[index + lane] : state.Lows[lane];
+				}
+			// the tail goes to the first lane
+			for (index = whole; index < Count; index++)
+			{
+				Weighted(index);
+				state.Squares[0] += Diff[index] * Diff[index];
+				state.Highs[0] = state.Highs[0] < Awd[index] ? Awd[index] : state.Highs[0];
+				state.Lows[0] = state.Lows[0] > Awd[index] ? Awd[index] : state.Lows[0];
+			}
+
+			Result result{ state.Squares[0], state.Highs[0], state.Lows[0] };
+			for (size_t lane = 1; lane < Lanes; lane++)
+			{
+				result.Square += state.Squares[lane];
+				result.High = result.High < state.Highs[lane] ? state.Highs[lane] : result.High;
+				result.Low = result.Low > state.Lows[lane] ? state.Lows[lane] : result.Low;
+			}
+			return result;
+		}
+
+		// extremes of the running sum of Count > 0 differences. The quarters of the block
+		// are summed in the lanes, the last quarter takes the tail
+		static PrefixResult Prefix(const V* Diff, size_t Count)
+		{
+			const size_t quarter{ Count / Lanes };
+			QuartersT state;
+			for (size_t lane = 0; lane < Lanes; lane++)
+				state.Highs[lane] = state.Lows[lane] = Diff[quarter > 0 ? lane * quarter : 0];
+
+			const auto Add = [&state](size_t lane, const V& diff)
+			{
+				state.Sums[lane] += diff;
+				state.Highs[lane] = state.Highs[lane] < state.Sums[lane] ? state.Sums[lane] : state.Highs[lane];
+				state.Lows[lane] = state.Lows[lane] > state.Sums[lane] ? state.Sums[lane] : state.Lows[lane];
+			};
+
+			size_t index{ 0 };
+#ifdef TIMESERIES_COMPARE_SSE2
+			if constexpr (std::is_same_v<V, double>)
+			{
+				VectorizedPrefix(Diff, quarter, state);
+				index = quarter;
+			}
+#endif
+			for (; index < quarter; index++)
+				for (size_t lane = 0; lane < Lanes; lane++)
+					Add(lane, Diff[lane * quarter + index]);
+			for (index = Lanes * quarter; index < Count; index++)
+				Add(Lanes - 1, Diff[index]);
+
+			// extremes of the block from the quarters shifted by the sums before them
+			PrefixResult result{ 0, state.Highs[0], state.Lows[0] };
+			for (size_t lane = 0; lane < Lanes; lane++)
+			{
+				const V high{ result.Sum + state.Highs[lane] }, low{ result.Sum + state.Lows[lane] };
+				result.High = result.High < high ? high : result.High;
+				result.Low = result.Low > low ? low : result.Low;
+				result.Sum += state.Sums[lane];
+			}
+			return result;
+		}
+	};
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdexcept>
+#include <string_view>
+#include "fmt/core.h"
+#include "fmt/format.h"
+
+namespace timeseries
+{
+	class Exception : public std::runtime_error
+	{
+	public:
+		template <typename... Args>
+		Exception(std::string_view Format, Args&&... args) : std::runtime_error(fmt::format(Format, args...)) {}
+	};
+}
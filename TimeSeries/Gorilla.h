@@ -0,0 +1,465 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+#include "Exception.h"
+#include "Binary.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace timeseries
+{
+	// header of the Gorilla-compressed series file followed by the bit stream:
+	// delta-of-delta encoded time bits and XOR encoded value bits
+	struct GorillaHeader
+	{
+		static constexpr char Signature[8] = { 'T', 'S', 'G', 'O', 'R', 'I', 'L', 'A' };
+		static constexpr uint32_t CurrentVersion = 1;
+
+		char Magic[8];
+		uint32_t Version;
+		uint32_t ByteOrder;		// BinaryHeader::NativeByteOrder of the writer
+		uint32_t TimeType;		// BinaryHeader::TypeCode of T
+		uint32_t ValueType;		// BinaryHeader::TypeCode of V
+		uint64_t Count;
+	};
+
+	// bit level helpers of the Gorilla codec
+	class GorillaBits
+	{
+	public:
+		static constexpr uint64_t Mask(unsigned Count)
+		{
+			return Count >= 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << Count) - 1;
+		}
+
+		// count of leading zeros of nonzero value
+		static inline unsigned LeadingZeros(uint64_t Value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, Value);
+			return 63 - static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(__builtin_clzll(Value));
+#endif
+		}
+
+		// count of trailing zeros of nonzero value
+		static inline unsigned TrailingZeros(uint64_t Value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward64(&index, Value);
+			return static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(__builtin_ctzll(Value));
+#endif
+		}
+
+		// bit pattern of the value, integers and floating points are coded the same way
+		template<typename X>
+		static inline uint64_t ToBits(const X& Value)
+		{
+			static_assert(std::is_arithmetic_v<X> && (sizeof(X) == 4 || sizeof(X) == 8), "GorillaBits - 32 or 64 bit types only");
+			std::conditional_t<sizeof(X) == 8, uint64_t, uint32_t> bits;
+			std::memcpy(&bits, &Value, sizeof(X));
+			return bits;
+		}
+
+		template<typename X>
+		static inline X FromBits(uint64_t Bits)
+		{
+			const std::conditional_t<sizeof(X) == 8, uint64_t, uint32_t> bits{ static_cast<decltype(bits)>(Bits) };
+			X value;
+			std::memcpy(&value, &bits, sizeof(X));
+			return value;
+		}
+	};
+
+	// writes bits MSB first to the stream by large blocks
+	class GorillaBitWriter
+	{
+	protected:
+		std::ostream& stream_;
+		std::vector<char> buffer_;
+		uint64_t word_ = 0;
+		unsigned bits_ = 0;		// bits used in word_
+
+		void Push(unsigned Bytes)
+		{
+			for (unsigned byte = 0; byte < Bytes; byte++)
+				buffer_.push_back(static_cast<char>(word_ >> (56 - 8 * byte)));
+			if (buffer_.size() >= BlockSize)
+				Flush();
+		}
+	public:
+		static constexpr size_t BlockSize = 1 << 16;
+
+		explicit GorillaBitWriter(std::ostream& stream) : stream_{ stream }
+		{
+			buffer_.reserve(BlockSize + sizeof(word_));
+		}
+
+		// writes Count low bits of Value
+		void Write(uint64_t Value, unsigned Count)
+		{
+			while (Count > 0)
+			{
+				const unsigned take{ (std::min)(64 - bits_, Count) };
+				const uint64_t chunk{ (Value >> (Count - take)) & GorillaBits::Mask(take) };
+				word_ = take == 64 ? chunk : (word_ << take) | chunk;
+				bits_ += take;
+				Count -= take;
+				if (bits_ == 64)
+				{
+					Push(8);
+					word_ = 0;
+					bits_ = 0;
+				}
+			}
+		}
+
+		void Flush()
+		{
+			stream_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+			buffer_.clear();
+		}
+
+		// pads the last byte with zeros and flushes the buffer
+		void Finish()
+		{
+			if (bits_ > 0)
+			{
+				word_ <<= 64 - bits_;
+				Push((bits_ + 7) / 8);
+				word_ = 0;
+				bits_ = 0;
+			}
+			Flush();
+		}
+	};
+
+	// reads bits MSB first from the stream by large blocks
+	class GorillaBitReader
+	{
+	protected:
+		std::istream& stream_;
+		std::vector<char> buffer_;
+		size_t position_ = 0;
+		size_t available_ = 0;
+		uint64_t word_ = 0;		// unread bits left aligned
+		unsigned bits_ = 0;
+
+		void Refill()
+		{
+			while (bits_ <= 56)
+			{
+				if (position_ == available_)
+				{
+					stream_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+					available_ = static_cast<size_t>(stream_.gcount());
+					position_ = 0;
+					if (available_ == 0)
+						break;
+				}
+				word_ |= static_cast<uint64_t>(static_cast<unsigned char>(buffer_[position_++])) << (56 - bits_);
+				bits_ += 8;
+			}
+			if (bits_ == 0)
+				throw Exception("GorillaBitReader - unexpected end of the stream");
+		}
+	public:
+		explicit GorillaBitReader(std::istream& stream) : stream_{ stream }, buffer_(GorillaBitWriter::BlockSize) {}
+
+		// reads Count bits to the low bits of the result
+		uint64_t Read(unsigned Count)
+		{
+			uint64_t value{ 0 };
+			while (Count > 0)
+			{
+				if (bits_ == 0)
+					Refill();
+				const unsigned take{ (std::min)(bits_, Count) };
+				value = take == 64 ? word_ : (value << take) | (word_ >> (64 - take));
+				word_ = take == 64 ? 0 : word_ << take;
+				bits_ -= take;
+				Count -= take;
+			}
+			return value;
+		}
+	};
+
+	// Gorilla codec state. Times are coded as delta-of-delta of their bit patterns,
+	// which stays near zero for the uniform and slowly changing steps, values are
+	// XORed with the previous value and only the meaningful bits are stored
+	template<typename T, typename V>
+	class GorillaCodecT
+	{
+	protected:
+		static constexpr unsigned TimeBits = sizeof(T) * 8;
+		static constexpr unsigned ValueBits = sizeof(V) * 8;
+
+		// delta-of-delta buckets: prefix length, value bits
+		struct Bucket
+		{
+			unsigned Prefix;
+			unsigned Bits;
+		};
+		static constexpr Bucket Buckets[] = { {2, 7}, {3, 9}, {4, 12} };
+
+		size_t count_ = 0;
+		uint64_t time_ = 0;
+		uint64_t delta_ = 0;
+		uint64_t value_ = 0;
+		unsigned leading_ = 0;
+		unsigned trailing_ = 0;
+	};
+
+	template<typename T, typename V>
+	class GorillaEncoderT : protected GorillaCodecT<T, V>
+	{
+	protected:
+		using Codec = GorillaCodecT<T, V>;
+		GorillaBitWriter writer_;
+
+		void EncodeTime(uint64_t Time)
+		{
+			const uint64_t delta{ Time - Codec::time_ };
+			const auto dod{ static_cast<int64_t>(delta - Codec::delta_) };
+			Codec::time_ = Time;
+			Codec::delta_ = delta;
+
+			if (dod == 0)
+			{
+				writer_.Write(0, 1);
+				return;
+			}
+
+			for (const auto& bucket : Codec::Buckets)
+			{
+				const int64_t half{ int64_t{ 1 } << (bucket.Bits - 1) };
+				if (dod >= -half && dod < half)
+				{
+					// prefix is bucket.Prefix - 1 ones followed by zero
+					writer_.Write(GorillaBits::Mask(bucket.Prefix) - 1, bucket.Prefix);
+					writer_.Write(static_cast<uint64_t>(dod), bucket.Bits);
+					return;
+				}
+			}
+			writer_.Write(0xF, 4);
+			writer_.Write(static_cast<uint64_t>(dod), 64);
+		}
+
+		void EncodeValue(uint64_t Value)
+		{
+			const uint64_t xored{ Value ^ Codec::value_ };
+			Codec::value_ = Value;
+			if (xored == 0)
+			{
+				writer_.Write(0, 1);
+				return;
+			}
+
+			const unsigned leading{ (std::min)(GorillaBits::LeadingZeros(xored) - (64 - Codec::ValueBits), 31u) };
+			const unsigned trailing{ GorillaBits::TrailingZeros(xored) };
+			if (Codec::count_ > 1 && leading >= Codec::leading_ && trailing >= Codec::trailing_)
+			{
+				// meaningful bits fit the previous window
+				writer_.Write(0b10, 2);
+				writer_.Write(xored >> Codec::trailing_, Codec::ValueBits - Codec::leading_ - Codec::trailing_);
+				return;
+			}
+
+			const unsigned meaningful{ Codec::ValueBits - leading - trailing };
+			writer_.Write(0b11, 2);
+			writer_.Write(leading, 5);
+			writer_.Write(meaningful - 1, 6);
+			writer_.Write(xored >> trailing, meaningful);
+			Codec::leading_ = leading;
+			Codec::trailing_ = trailing;
+		}
+	public:
+		explicit GorillaEncoderT(std::ostream& stream) : writer_{ stream } {}
+
+		void Append(const T& Time, const V& Value)
+		{
+			const auto time{ GorillaBits::ToBits(Time) }, value{ GorillaBits::ToBits(Value) };
+			if (Codec::count_ == 0)
+			{
+				writer_.Write(time, Codec::TimeBits);
+				writer_.Write(value, Codec::ValueBits);
+				Codec::time_ = time;
+				Codec::value_ = value;
+			}
+			else
+			{
+				EncodeTime(time);
+				EncodeValue(value);
+			}
+			Codec::count_++;
+		}
+
+		inline size_t size() const { return Codec::count_; }
+		void Finish() { writer_.Finish(); }
+	};
+
+	template<typename T, typename V>
+	class GorillaDecoderT : protected GorillaCodecT<T, V>
+	{
+	protected:
+		using Codec = GorillaCodecT<T, V>;
+		GorillaBitReader reader_;
+
+		void DecodeTime()
+		{
+			unsigned prefix{ 0 };
+			while (prefix < 4 && reader_.Read(1))
+				prefix++;
+
+			uint64_t dod{ 0 };
+			if (prefix == 4)
+				dod = reader_.Read(64);
+			else if (prefix > 0)
+			{
+				const auto bits{ Codec::Buckets[prefix - 1].Bits };
+				dod = reader_.Read(bits);
+				// sign extension
+				if (dod >> (bits - 1))
+					dod |= ~GorillaBits::Mask(bits);
+			}
+			Codec::delta_ += dod;
+			Codec::time_ += Codec::delta_;
+		}
+
+		void DecodeValue()
+		{
+			if (!reader_.Read(1))
+				return;
+
+			if (reader_.Read(1))
+			{
+				Codec::leading_ = static_cast<unsigned>(reader_.Read(5));
+				const unsigned meaningful{ static_cast<unsigned>(reader_.Read(6)) + 1 };
+				Codec::trailing_ = Codec::ValueBits - Codec::leading_ - meaningful;
+			}
+			Codec::value_ ^= reader_.Read(Codec::ValueBits - Codec::leading_ - Codec::trailing_) << Codec::trailing_;
+		}
+	public:
+		explicit GorillaDecoderT(std::istream& stream) : reader_{ stream } {}
+
+		void Next(T& Time, V& Value)
+		{
+			if (Codec::count_ == 0)
+			{
+				Codec::time_ = reader_.Read(Codec::TimeBits);
+				Codec::value_ = reader_.Read(Codec::ValueBits);
+			}
+			else
+			{
+				DecodeTime();
+				DecodeValue();
+			}
+			Codec::count_++;
+			Time = GorillaBits::FromBits<T>(Codec::time_);
+			Value = GorillaBits::FromBits<V>(Codec::value_);
+		}
+	};
+
+	// Gorilla-compressed series file
+	class GorillaFile
+	{
+	public:
+		// checks the signature only
+		static bool Is(const std::filesystem::path& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			char magic[sizeof(GorillaHeader::Signature)];
+			return file.read(magic, sizeof(magic)) && std::memcmp(magic, GorillaHeader::Signature, sizeof(magic)) == 0;
+		}
+
+		// writes Data with Time(i)/Value(i) access
+		template<typename T, typename V, typename DataT>
+		static void Write(const std::filesystem::path& path, const DataT& Data)
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+				throw Exception("GorillaFile::Write - failed to open {}", path.string());
+
+			GorillaHeader header{};
+			std::memcpy(header.Magic, GorillaHeader::Signature, sizeof(GorillaHeader::Signature));
+			header.Version = GorillaHeader::CurrentVersion;
+			header.ByteOrder = BinaryHeader::NativeByteOrder;
+			header.TimeType = BinaryHeader::TypeCode<T>();
+			header.ValueType = BinaryHeader::TypeCode<V>();
+			header.Count = Data.size();
+			file.write(reinterpret_cast<const char*>(&header), sizeof(GorillaHeader));
+
+			GorillaEncoderT<T, V> encoder(file);
+			for (size_t index = 0; index < Data.size(); index++)
+				encoder.Append(Data.Time(index), Data.Value(index));
+			encoder.Finish();
+
+			if (!file.flush())
+				throw Exception("GorillaFile::Write - failed to write {}", path.string());
+		}
+
+		// reads and validates the header of the file opened, returns count of the points
+		template<typename T, typename V>
+		static uint64_t ReadHeader(std::istream& file, const std::filesystem::path& path)
+		{
+			GorillaHeader header{};
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(GorillaHeader)) ||
+				std::memcmp(header.Magic, GorillaHeader::Signature, sizeof(GorillaHeader::Signature)) != 0)
+				throw Exception("GorillaFile::Read - {} is not a Gorilla series", path.string());
+			if (header.Version != GorillaHeader::CurrentVersion)
+				throw Exception("GorillaFile::Read - {} has unsupported version {}", path.string(), header.Version);
+			if (header.ByteOrder != BinaryHeader::NativeByteOrder)
+				throw Exception("GorillaFile::Read - {} has foreign byte order", path.string());
+			if (header.TimeType != BinaryHeader::TypeCode<T>() || header.ValueType != BinaryHeader::TypeCode<V>())
+				throw Exception("GorillaFile::Read - {} types {:#x}/{:#x} do not match {:#x}/{:#x}", path.string(),
+					header.TimeType, header.ValueType, BinaryHeader::TypeCode<T>(), BinaryHeader::TypeCode<V>());
+			// the first point is raw and each next one takes two bits at least,
+			// so the count of the corrupted header is caught before the allocation
+			const uint64_t bits{ (static_cast<uint64_t>(std::filesystem::file_size(path)) - sizeof(GorillaHeader)) * 8 };
+			constexpr uint64_t first{ (sizeof(T) + sizeof(V)) * 8 };
+			if (header.Count > 0 && (bits < first || header.Count - 1 > (bits - first) / 2))
+				throw Exception("GorillaFile::Read - {} is truncated: {} points do not fit {} bytes", path.string(),
+					header.Count, bits / 8);
+			return header.Count;
+		}
+
+		// decodes the file by blocks and calls Reserve(count) once, then Record(time, value) for
+		// each point. If Record returns bool, decoding stops when it returns false
+		template<typename T, typename V, typename ReserveFn, typename RecordFn>
+		static void Read(const std::filesystem::path& path, ReserveFn&& Reserve, RecordFn&& Record)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open())
+				throw Exception("GorillaFile::Read - failed to open {}", path.string());
+
+			const auto count{ ReadHeader<T, V>(file, path) };
+			Reserve(static_cast<size_t>(count));
+			GorillaDecoderT<T, V> decoder(file);
+			T time{};
+			V value{};
+			for (uint64_t point = 0; point < count; point++)
+			{
+				decoder.Next(time, value);
+				if constexpr (std::is_same_v<decltype(Record(time, value)), bool>)
+				{
+					if (!Record(time, value))
+						break;
+				}
+				else
+					Record(time, value);
+			}
+		}
+	};
+}
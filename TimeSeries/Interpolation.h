@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "Exception.h"
+
+namespace timeseries
+{
+	// base of the interpolation policies. Get(Data, Place, Time) interpolates Data at Time
+	// using the segment around Place, which is the first point with time not less than Time.
+	// Times out of the series take the first or the last segment. Policy implements
+	// At(Data, Left, Time) for the segment from the point Left and may compute the
+	// coefficients of the segments in Prepare(Data), which is called before the queries.
+	// Invalidate() is called when the points are changed, the next Prepare computes again
+	template<typename T, typename V, typename Policy>
+	class InterpolationT
+	{
+	public:
+		// left point of the segment for Place
+		static size_t Segment(size_t Size, size_t Place, const T& Time)
+		{
+			if (Size < 2)
+				throw Exception("Interpolator::Get - Failed at t={}", Time);
+			return (std::min)(Place > 0 ? Place - 1 : 0, Size - 2);
+		}
+
+		template<typename DataT>
+		V Get(const DataT& Data, size_t Place, const T& Time) const
+		{
+			return static_cast<const Policy&>(*this).At(Data, Segment(Data.size(), Place, Time), Time);
+		}
+
+		template<typename DataT>
+		void Prepare(const DataT&) {}
+
+		void Invalidate() {}
+	};
+
+	// zero-order hold: the value of the last point not later than the time,
+	// the first value before the series. Suits step-held controller signals
+	template<typename T, typename V>
+	class HoldInterpolationT : public InterpolationT<T, V, HoldInterpolationT<T, V>>
+	{
+	public:
+		template<typename DataT>
+		V At(const DataT& Data, size_t Left, const T& Time) const
+		{
+			return Time < Data.Time(Left + 1) ? Data.Value(Left) : Data.Value(Left + 1);
+		}
+	};
+
+	// linear interpolation between the points of the segment. The slope costs a single
+	// division, so it is computed in place and no coefficients are kept
+	template<typename T, typename V>
+	class LinearInterpolationT : public InterpolationT<T, V, LinearInterpolationT<T, V>>
+	{
+	public:
+		template<typename DataT>
+		V At(const DataT& Data, size_t Left, const T& Time) const
+		{
+			const T Tl{ Data.Time(Left) }, Tr{ Data.Time(Left + 1) };
+			const V Vl{ Data.Value(Left) }, Vr{ Data.Value(Left + 1) };
+			const auto div{ Tr - Tl };
+			// if denominator is zero - choose points left
+			// or right to Time given
+			if (std::abs(div) > 0)
+				return (Vr - Vl) / (Tr - Tl) * (Time - Tl) + Vl;
+			else
+				return Tl > Time ? Vl : Vr;
+		}
+	};
+
+	// piecewise cubic Hermite interpolation. Policy computes the slopes at the points of
+	// the run of ascending times by Slopes(h, delta, count, m), where h and delta are the
+	// steps and the divided differences of count - 1 segments. Coefficients of the segments
+	// are computed once after the points are changed, so a query is the single multiply-add chain.
+	// Multivalue points split the series to the runs, which are interpolated separately
+	template<typename T, typename V, typename Policy>
+	class CubicInterpolationT : public InterpolationT<T, V, Policy>
+	{
+	protected:
+		// value of the segment is ((D * x + C) * x + B) * x + A, x is the time from the left point
+		struct Coefficients
+		{
+			V A, B, C, D;
+		};
+		std::vector<Coefficients> segments_;
+		bool prepared_ = false;		// coefficients match the points
+	public:
+		template<typename DataT>
+		void Prepare(const DataT& Data)
+		{
+			if (prepared_)
+				return;
+
+			const size_t size{ Data.size() };
+			segments_.assign(size > 1 ? size - 1 : 0, { 0, 0, 0, 0 });
+			std::vector<V> h, delta, m;
+			for (size_t first = 0; first + 1 < size;)
+			{
+				// run of ascending times from first to last
+				size_t last{ first + 1 };
+				while (last < size && Data.Time(last - 1) < Data.Time(last))
+					last++;
+				last--;
+
+				if (last == first)
+				{
+					// zero length segment of the multivalue point is held in At
+					first++;
+					continue;
+				}
+
+				const size_t count{ last - first + 1 };
+				h.resize(count - 1);
+				delta.resize(count - 1);
+				m.resize(count);
+				for (size_t segment = 0; segment < count - 1; segment++)
+				{
+					h[segment] = static_cast<V>(Data.Time(first + segment + 1) - Data.Time(first + segment));
+					delta[segment] = (Data.Value(first + segment + 1) - Data.Value(first + segment)) / h[segment];
+				}
+
+				if (count == 2)
+					m[0] = m[1] = delta[0];
+				else
+					Policy::Slopes(h.data(), delta.data(), count, m.data());
+
+				for (size_t segment = 0; segment < count - 1; segment++)
+				{
+					const V hs{ h[segment] }, ds{ delta[segment] }, ml{ m[segment] }, mr{ m[segment + 1] };
+					segments_[first + segment] = { Data.Value(first + segment), ml,
+												   (3 * ds - 2 * ml - mr) / hs,
+												   (ml + mr - 2 * ds) / (hs * hs) };
+				}
+				first = last;
+			}
+			prepared_ = true;
+		}
+
+		void Invalidate()
+		{
+			prepared_ = false;
+		}
+
+		template<typename DataT>
+		V At(const DataT& Data, size_t Left, const T& Time) const
+		{
+			const T Tl{ Data.Time(Left) };
+			if (!(Tl < Data.Time(Left + 1)))
+				return Tl > Time ? Data.Value(Left) : Data.Value(Left + 1);
+			const auto& segment{ segments_[Left] };
+			const V x{ static_cast<V>(Time - Tl) };
+			return ((segment.D * x + segment.C) * x + segment.B) * x + segment.A;
+		}
+	};
+
+	// monotone piecewise cubic (PCHIP, Fritsch-Carlson slopes): no overshoots
+	// between the points, the shape of the data is preserved
+	template<typename T, typename V>
+	class PchipInterpolationT : public CubicInterpolationT<T, V, PchipInterpolationT<T, V>>
+	{
+	protected:
+		// three point estimate of the end slope limited to preserve the shape
+		static V EndSlope(V h0, V h1, V d0, V d1)
+		{
+			const V slope{ ((2 * h0 + h1) * d0 - h0 * d1) / (h0 + h1) };
+			if ((slope > 0) != (d0 > 0) || slope == 0 || d0 == 0)
+				return 0;
+			if ((d0 > 0) != (d1 > 0) && std::abs(slope) > std::abs(3 * d0))
+				return 3 * d0;
+			return slope;
+		}
+	public:
+		static void Slopes(const V* h, const V* delta, size_t Count, V* m)
+		{
+			for (size_t point = 1; point < Count - 1; point++)
+			{
+				const V dl{ delta[point - 1] }, dr{ delta[point] };
+				if (dl * dr <= 0)
+					m[point] = 0;
+				else
+				{
+					// weighted harmonic mean of the differences
+					const V w1{ 2 * h[point] + h[point - 1] }, w2{ h[point] + 2 * h[point - 1] };
+					m[point] = (w1 + w2) / (w1 / dl + w2 / dr);
+				}
+			}
+			m[0] = EndSlope(h[0], h[1], delta[0], delta[1]);
+			m[Count - 1] = EndSlope(h[Count - 2], h[Count - 3], delta[Count - 2], delta[Count - 3]);
+		}
+	};
+
+	// natural cubic spline: twice continuously differentiable with the zero second
+	// derivative at the ends of the runs. Suits smooth signals as machine angles
+	template<typename T, typename V>
+	class SplineInterpolationT : public CubicInterpolationT<T, V, SplineInterpolationT<T, V>>
+	{
+	public:
+		// tridiagonal system of the slopes solved by the Thomas algorithm
+		static void Slopes(const V* h, const V* delta, size_t Count, V* m)
+		{
+			std::vector<V> upper(Count);
+			// natural end: 2 * m0 + m1 = 3 * d0
+			upper[0] = V{ 1 } / 2;
+			m[0] = 3 * delta[0] / 2;
+			for (size_t point = 1; point < Count; point++)
+			{
+				const bool end{ point == Count - 1 };
+				// row: a * m[point - 1] + b * m[point] + c * m[point + 1] = r
+				const V a{ end ? V{ 1 } : 1 / h[point - 1] };
+				const V b{ end ? V{ 2 } : 2 / h[point - 1] + 2 / h[point] };
+				const V c{ end ? V{ 0 } : 1 / h[point] };
+				const V r{ end ? 3 * delta[point - 1] : 3 * (delta[point - 1] / h[point - 1] + delta[point] / h[point]) };
+				const V pivot{ b - a * upper[point - 1] };
+				upper[point] = c / pivot;
+				m[point] = (r - a * m[point - 1]) / pivot;
+			}
+			for (size_t point = Count - 1; point-- > 0;)
+				m[point] -= upper[point] * m[point + 1];
+		}
+	};
+
+	// linear interpolation is the default one
+	template<typename T, typename V>
+	using Interpolator = LinearInterpolationT<T, V>;
+}
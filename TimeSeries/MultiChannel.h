@@ -0,0 +1,209 @@
+#pragma once
+#include "TimeSeries.h"
+
+namespace timeseries
+{
+	// series of several channels sharing the single time axis.
+	// Values of each channel are kept contiguous
+	template<typename T, typename V>
+	class MultiChannelSeriesT
+	{
+	public:
+		using Options = TimeSeriesOptionsT<T, V>;
+		using CompareResult = CompareResultT<T, V>;
+		// aligned times processed for all the channels at once
+		static constexpr size_t BlockSize = 2048;
+	protected:
+		friend class timeseries_test::TimeSeriesTests;
+		std::vector<T> times_;
+		std::vector<std::vector<V>> channels_;
+		mutable bool Checked_ = false;
+
+		// time axis with the channel values accessed as the storage
+		class ChannelData
+		{
+		protected:
+			const std::vector<T>& times_;
+			const std::vector<V>& values_;
+		public:
+			ChannelData(const std::vector<T>& Times, const std::vector<V>& Values) : times_{ Times }, values_{ Values } {}
+			inline size_t size() const { return times_.size(); }
+			inline const T& Time(size_t Index) const { return times_[Index]; }
+			inline const V& Value(size_t Index) const { return values_[Index]; }
+		};
+
+		// slots of both series for the time of union time axis
+		struct AlignedTime
+		{
+			T Time;
+			TimeSlot Slot1;
+			TimeSlot Slot2;
+		};
+
+		void Check() const
+		{
+			if (Checked_)
+				return;
+
+			for (size_t TimePoint = 1; TimePoint < times_.size(); TimePoint++)
+				if (times_[TimePoint - 1] > times_[TimePoint])
+					throw Exception("MultiChannelSeriesT::Check - time series is not monotonic : [{}] > [{}]",
+						times_[TimePoint - 1],
+						times_[TimePoint]);
+
+			Checked_ = true;
+		}
+
+	public:
+		MultiChannelSeriesT() = default;
+		explicit MultiChannelSeriesT(size_t Channels) : channels_(Channels) {}
+		MultiChannelSeriesT(std::vector<T> Times, std::vector<std::vector<V>> Channels) : 
+			times_{ std::move(Times) }, 
+			channels_{ std::move(Channels) }
+		{
+			for (const auto& channel : channels_)
+				if (channel.size() != times_.size())
+					throw Exception(TimeSeriesData<T, V>::TimeSeriesDoNotMatch, times_.size(), channel.size());
+		}
+
+		// loads value Columns from "time;c1;c2;...;cN" file with optional header.
+		// The file is parsed once and the columns not requested are not converted
+		MultiChannelSeriesT(const std::filesystem::path& path, const std::vector<size_t>& Columns) : channels_(Columns.size())
+		{
+			CSVReader(path).ReadColumns<T, V>(Columns, [this](const T& time, const V* values)
+				{
+					emplace_back(time, values);
+				});
+		}
+
+		// loads columns by names from the header
+		MultiChannelSeriesT(const std::filesystem::path& path, const std::vector<std::string>& Names) :
+			MultiChannelSeriesT(path, CSVReader(path).Columns(Names)) {}
+
+		inline size_t size() const { return times_.size(); }
+		inline bool empty() const { return times_.empty(); }
+		inline size_t Channels() const { return channels_.size(); }
+		inline const T& Time(size_t Index) const { return times_[Index]; }
+		inline const V& Value(size_t Channel, size_t Index) const { return channels_[Channel][Index]; }
+
+		// adds time point with the values for all the channels
+		void emplace_back(const T& Time, const V* Values)
+		{
+			times_.emplace_back(Time);
+			for (auto& channel : channels_)
+				channel.emplace_back(*Values++);
+			Checked_ = false;
+		}
+
+		void reserve(size_t Size)
+		{
+			times_.reserve(Size);
+			for (auto& channel : channels_)
+				channel.reserve(Size);
+		}
+
+		// copies the channel to the separate series
+		TimeSeries<T, V> Channel(size_t Channel) const
+		{
+			return TimeSeries<T, V>(times_.size(), times_.data(), channels_.at(Channel).data());
+		}
+
+		// evaluates each channel at the ascending Times. The time axis is swept once
+		// by blocks and each block is applied to all the channels while it is in cache
+		std::vector<std::vector<V>> Evaluate(const std::vector<T>& Times, const Options& options) const
+		{
+			Check();
+			std::vector<std::vector<V>> values(Channels(), std::vector<V>(Times.size()));
+			if (Channels() == 0)
+				return values;
+
+			const ChannelData axis(times_, channels_.front());
+			TimeCursor<T, ChannelData> cursor(axis);
+			EvaluationBlockT<T, V> block(options);
+			for (size_t time = 0; time < Times.size();)
+			{
+				if (time > 0 && Times[time] < Times[time - 1])
+					throw Exception("MultiChannelSeriesT::Evaluate - times are not ascending : [{}] > [{}]", Times[time - 1], Times[time]);
+				const auto swept{ block.Sweep(axis, cursor, Times.data() + time, Times.size() - time) };
+				for (size_t channel = 0; channel < Channels(); channel++)
+					block.Apply(ChannelData(times_, channels_[channel]), values[channel].data() + time);
+				time += swept;
+			}
+			return values;
+		}
+
+		// compares each channel with the channel of ExtData with the same index. The series
+		// are compared by the chunks of CompareChunks merged in order, as Compare of the
+		// channel series does, so the results are exactly the same. Time axes of the chunk
+		// are aligned once, then the channels are swept by blocks of aligned times to keep
+		// the alignment in cache. Pairs of the block are passed to the results at once
+		std::vector<CompareResult> Compare(const MultiChannelSeriesT& ExtData, const Options& options) const
+		{
+			if (Channels() != ExtData.Channels())
+				throw Exception("MultiChannelSeriesT::Compare - channels count do not match: {} and {}", Channels(), ExtData.Channels());
+
+			Check();
+			ExtData.Check();
+
+			std::vector<CompareResult> results(Channels());
+
+			if (!empty() && !ExtData.empty() && Channels() > 0)
+			{
+				const ChannelData axis1(times_, channels_.front()), axis2(ExtData.times_, ExtData.channels_.front());
+				const auto chunks{ CompareChunks(axis1, axis2, options) };
+				std::vector<AlignedTime> aligned;
+				std::vector<T> times;
+				std::vector<V> values1, values2;
+				std::vector<CompareResult> comps(Channels());
+
+				for (size_t chunk = 0; chunk + 1 < chunks.size(); chunk++)
+				{
+					TimeCursor<T, ChannelData> cursor1(axis1), cursor2(axis2);
+					aligned.clear();
+					ForEachUnionTime(axis1, chunks[chunk].first, chunks[chunk + 1].first,
+									 axis2, chunks[chunk].second, chunks[chunk + 1].second, options, [&](const T& Time)
+						{
+							aligned.push_back({ Time,
+												cursor1.Seek(Time, options.TimeTolerance()),
+												cursor2.Seek(Time, options.TimeTolerance()) });
+						});
+
+					for (size_t block = 0; block < aligned.size(); block += BlockSize)
+					{
+						const auto blockend{ (std::min)(block + BlockSize, aligned.size()) };
+						for (size_t channel = 0; channel < Channels(); channel++)
+						{
+							const ChannelData data1(times_, channels_[channel]), data2(ExtData.times_, ExtData.channels_[channel]);
+							times.clear();
+							values1.clear();
+							values2.clear();
+							for (size_t time = block; time < blockend; time++)
+							{
+								const auto& point{ aligned[time] };
+								ForEachSlotPair(data1, point.Slot1, data2, point.Slot2, point.Time, options,
+									[&times, &values1, &values2](const T&, const T& t1, const V& v1, const V& v2)
+									{
+										times.push_back(t1);
+										values1.push_back(v1);
+										values2.push_back(v2);
+									});
+							}
+							comps[channel].Update(times.data(), values1.data(), values2.data(), times.size(), options);
+						}
+					}
+
+					for (size_t channel = 0; channel < Channels(); channel++)
+					{
+						results[channel].Merge(comps[channel].Finish());
+						comps[channel].Reset();
+					}
+				}
+			}
+
+			for (auto& comps : results)
+				comps.Finish();
+
+			return results;
+		}
+	};
+}
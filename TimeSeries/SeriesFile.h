@@ -0,0 +1,247 @@
+#pragma once
+#include <memory>
+#include "TimeSeries.h"
+
+namespace timeseries
+{
+	// sequential reader of the series file of any format: CSV, binary or Gorilla.
+	// Points are appended to the columns by blocks of about BlockPoints points
+	template<typename T, typename V>
+	class SeriesFileReaderT
+	{
+	protected:
+		std::filesystem::path path_;
+		size_t BlockPoints_;
+		std::unique_ptr<CSVBlocks> csv_;
+		bool csvstopped_ = false;
+		std::unique_ptr<BinaryView<T, V>> binary_;
+		std::unique_ptr<std::ifstream> gorillafile_;
+		std::unique_ptr<GorillaDecoderT<T, V>> gorilla_;
+		size_t position_ = 0;
+		size_t count_ = 0;		// count of points in binary and Gorilla files
+	public:
+		// CSV blocks are sized in bytes assuming this length of the line
+		static constexpr size_t CSVLineSize = 32;
+
+		SeriesFileReaderT(const std::filesystem::path& path, size_t BlockPoints) :
+			path_{ path },
+			BlockPoints_{ (std::max)(BlockPoints, static_cast<size_t>(1)) }
+		{
+			if (BinaryView<T, V>::Is(path))
+			{
+				binary_ = std::make_unique<BinaryView<T, V>>(path);
+				count_ = binary_->size();
+			}
+			else if (GorillaFile::Is(path))
+			{
+				gorillafile_ = std::make_unique<std::ifstream>(path, std::ios::binary);
+				count_ = static_cast<size_t>(GorillaFile::ReadHeader<T, V>(*gorillafile_, path));
+				gorilla_ = std::make_unique<GorillaDecoderT<T, V>>(*gorillafile_);
+			}
+			else
+				csv_ = std::make_unique<CSVBlocks>(path, BlockPoints_ * CSVLineSize);
+		}
+
+		// appends the next block of points, returns false if the series is over
+		bool Read(std::vector<T>& Times, std::vector<V>& Values)
+		{
+			if (csv_)
+			{
+				const char* first{ nullptr };
+				const char* last{ nullptr };
+				const auto size{ Times.size() };
+				// as the whole file reader, stop on the first malformed record
+				while (Times.size() == size && !csvstopped_ && csv_->Next(first, last))
+					csvstopped_ = !CSVParser::Parse<T, V>(first, last, [&Times, &Values](const T& time, const V& value)
+						{
+							Times.emplace_back(time);
+							Values.emplace_back(value);
+						});
+				return Times.size() > size;
+			}
+
+			const auto block{ (std::min)(BlockPoints_, count_ - position_) };
+			if (binary_)
+			{
+				Times.insert(Times.end(), binary_->Times() + position_, binary_->Times() + position_ + block);
+				Values.insert(Values.end(), binary_->Values() + position_, binary_->Values() + position_ + block);
+			}
+			else
+			{
+				T time{};
+				V value{};
+				for (size_t point = 0; point < block; point++)
+				{
+					gorilla_->Next(time, value);
+					Times.emplace_back(time);
+					Values.emplace_back(value);
+				}
+			}
+			position_ += block;
+			return block > 0;
+		}
+	};
+
+	// sliding window over the series file with index access as the in-memory storages have.
+	// Points are read by blocks on demand and only the last half of the window is kept when
+	// it is full, so the memory is bounded by Window points and a block. Access to the points
+	// dropped from the window is an error
+	template<typename T, typename V>
+	class SeriesWindowT
+	{
+	protected:
+		std::filesystem::path path_;
+		size_t Window_;
+		size_t size_ = 0;
+		mutable SeriesFileReaderT<T, V> reader_;
+		mutable std::vector<T> times_;
+		mutable std::vector<V> values_;
+		mutable size_t start_ = 0;		// index of the first point in the window
+
+		void Load(size_t Index) const
+		{
+			if (Index < start_)
+				throw Exception("SeriesWindowT - point {} of {} is out of the window of {} points", Index, path_.string(), Window_);
+
+			while (Index >= start_ + times_.size())
+			{
+				if (times_.size() >= Window_)
+				{
+					const auto drop{ times_.size() - Window_ / 2 };
+					times_.erase(times_.begin(), times_.begin() + drop);
+					values_.erase(values_.begin(), values_.begin() + drop);
+					start_ += drop;
+				}
+				if (!reader_.Read(times_, values_))
+					throw Exception("SeriesWindowT - point {} is out of {}", Index, path_.string());
+			}
+		}
+	public:
+		static constexpr size_t DefaultWindow = 1 << 20;
+		static constexpr size_t MinWindow = 16;
+
+		// counts the points and checks their order by the separate pass over the file
+		SeriesWindowT(const std::filesystem::path& path, size_t Window = DefaultWindow) :
+			path_{ path },
+			Window_{ (std::max)(Window, MinWindow) },
+			reader_{ path, (std::max)(Window_ / 4, static_cast<size_t>(1)) }
+		{
+			SeriesFileReaderT<T, V> counter(path, Window_);
+			std::vector<T> times;
+			std::vector<V> values;
+			while (counter.Read(times, values))
+			{
+				for (size_t point = 1; point < times.size(); point++)
+					if (times[point - 1] > times[point])
+						throw Exception("SeriesWindowT - time series {} is not monotonic : [{}] > [{}]", path.string(), times[point - 1], times[point]);
+				size_ += times.size() - 1;
+				// the last point is kept to check the order across the blocks
+				times.erase(times.begin(), times.end() - 1);
+				values.erase(values.begin(), values.end() - 1);
+			}
+			size_ += times.size();
+		}
+
+		inline size_t size() const { return size_; }
+		inline bool empty() const { return size_ == 0; }
+
+		T Time(size_t Index) const
+		{
+			if (Index < start_ || Index >= start_ + times_.size())
+				Load(Index);
+			return times_[Index - start_];
+		}
+
+		V Value(size_t Index) const
+		{
+			if (Index < start_ || Index >= start_ + times_.size())
+				Load(Index);
+			return values_[Index - start_];
+		}
+	};
+
+	// compares two series files of any size with the same alignment and aggregation
+	// as TimeSeriesData::Compare. The result is exactly the same as the result of the
+	// in-memory Compare, while the memory is bounded by Window points of each series.
+	// Each file is read twice: by the counting pass of the window and by the walk of
+	// the union times, which finds the boundaries of the chunks of CompareChunks on the
+	// way. The windows are read forward only, the cursors follow the walk sequentially
+	template<typename T, typename V>
+	CompareResultT<T, V> CompareFiles(const std::filesystem::path& path1, const std::filesystem::path& path2,
+		const TimeSeriesOptionsT<T, V>& options, size_t Window = SeriesWindowT<T, V>::DefaultWindow)
+	{
+		CompareResultT<T, V> result;
+		const SeriesWindowT<T, V> data1(path1, Window), data2(path2, Window);
+		if (data1.empty() || data2.empty())
+			return result.Finish();
+
+		constexpr size_t chunksize{ CompareResultT<T, V>::ChunkSize };
+		const size_t size1{ data1.size() }, size2{ data2.size() };
+		const T tolerance{ options.TimeTolerance() * 2.0 };
+		const auto& end{ options.Range().end };
+
+		// boundaries are the points of the longer series, see CompareChunks
+		const bool longer1{ size1 >= size2 };
+		const SeriesWindowT<T, V>& longer{ longer1 ? data1 : data2 };
+		const SeriesWindowT<T, V>& other{ longer1 ? data2 : data1 };
+		size_t t1{ 0 }, t2{ 0 };
+		const size_t& l{ longer1 ? t1 : t2 };
+		const size_t& o{ longer1 ? t2 : t1 };
+		size_t found{ 0 };			// block of the candidates with the boundary found
+		size_t checked{ longer.size() };
+
+		// the point l is checked once the points of the other series before it are walked,
+		// so o is its lower bound in the other series
+		const auto Boundary = [&]() -> bool
+		{
+			if (l >= longer.size() || l / chunksize <= found || l == checked)
+				return false;
+			const T time{ longer.Time(l) };
+			if (o < other.size() && other.Time(o) < time)
+				return false;
+			checked = l;
+			if (!(time - longer.Time(l - 1) > tolerance))
+				return false;
+			if (o > 0 && !(time - other.Time(o - 1) > tolerance))
+				return false;
+			found = l / chunksize;
+			return true;
+		};
+
+		TimeCursor<T, SeriesWindowT<T, V>> cursor1(data1, 0, true), cursor2(data2, 0, true);
+		CompareResultT<T, V> comps;
+		bool stored{ false };
+		T last{};
+		while (t1 < size1 || t2 < size2)
+		{
+			// the chunk is compared and merged as Compare does, the walk starts afresh
+			if (Boundary())
+			{
+				result.Merge(comps.Finish());
+				comps = CompareResultT<T, V>();
+				stored = false;
+			}
+
+			const bool first{ t2 == size2 || (t1 < size1 && data1.Time(t1) < data2.Time(t2)) };
+			const T time{ first ? data1.Time(t1++) : data2.Time(t2++) };
+			if (end.has_value() && time >= end.value())
+				break;
+
+			// cursors are moved by all the times walked to stay in the windows
+			const auto slot1{ cursor1.Seek(time, options.TimeTolerance()) };
+			const auto slot2{ cursor2.Seek(time, options.TimeTolerance()) };
+			if (options.TimeInRange(time) && (!stored || std::abs(last - time) > tolerance))
+			{
+				stored = true;
+				last = time;
+				ForEachSlotPair(data1, slot1, data2, slot2, time, options,
+					[&comps, &options](const T&, const T& t, const V& v1, const V& v2)
+					{
+						comps.Update(t, v1, v2, options);
+					});
+			}
+		}
+		result.Merge(comps.Finish());
+		return result.Finish();
+	}
+}
\ No newline at end of file
@@ -4,12 +4,27 @@ using namespace timeseries_test;
 
 using TSD = typename timeseries::TimeSeries<double, double>;
 using TSO = typename TSD::Options;
+using TSC = typename timeseries::TimeSeries<double, double, timeseries::TimeSeriesColumnsT<double, double>>;
+using TSUniform = typename timeseries::TimeSeriesUniformT<double, double>;
+using TSU = typename timeseries::TimeSeries<double, double, TSUniform>;
+using TSM = typename timeseries::TimeSeries<double, double, timeseries::TimeSeriesMappedT<double, double>>;
+using TSView = typename timeseries::TimeSeriesViewT<double, double>;
+using TSV = typename timeseries::TimeSeries<double, double, TSView>;
+template<template<typename, typename> class Interpolation>
+using TSI = typename timeseries::TimeSeries<double, double, timeseries::TimeSeriesDataT<double, double>, Interpolation<double, double>>;
 
 std::filesystem::path TimeSeriesTests::TestPath(const std::filesystem::path& testpath)
 {
 	return std::filesystem::path(TIMESERIES_TEST_PATH) /= testpath;
 }
 
+bool TimeSeriesTests::SameResult(const timeseries::CompareResultT<double, double>& lhs, const timeseries::CompareResultT<double, double>& rhs)
+{
+	return lhs.Max().t() == rhs.Max().t() && lhs.Max().v() == rhs.Max().v() &&
+		lhs.Min().t() == rhs.Min().t() && lhs.Min().v() == rhs.Min().v() &&
+		lhs.KSTest() == rhs.KSTest() && lhs.Sum() == rhs.Sum() && lhs.SqSum() == rhs.SqSum() && lhs.Avg() == rhs.Avg();
+}
+
 bool TimeSeriesTests::TestConstruct()
 {
 	bool ret{ true };
@@ -138,6 +153,86 @@ bool TimeSeriesTests::CompressTest()
 	return ret;
 }
 
+bool TimeSeriesTests::SwingingDoorTest()
+{
+	bool ret{ true };
+	// smooth curve with the step, which is the multivalue point
+	TSD series;
+	for (size_t i = 0; i <= 100000; i++)
+	{
+		const double time{ 0.0001 * static_cast<double>(i) };
+		series.emplace_back(time, std::sin(time) + (i > 50000 ? 1.0 : 0.0));
+		if (i == 50000)
+			series.emplace_back(time, std::sin(time) + 1.0);
+	}
+
+	TSO options;
+	options.SetValueTolerance(1e-4);
+	options.SetCompression(timeseries::CompressMethod::SwingingDoor);
+	TSD door{ series };
+	door.Compress(options);
+	ret &= Test(door.size() * 100 < series.size(), fmt::format("Swinging door ratio {}", series.size() / door.size()));
+
+	// every point is within the tolerance of the compressed series
+	bool bounded{ door.front().t() == series.front().t() && door.back().t() == series.back().t() };
+	size_t step{ 0 };
+	for (size_t point = 0; bounded && point < series.size(); point++)
+	{
+		const auto values{ door.GetTimePoints(series.Time(point), options) };
+		if (values.size() > 1)
+			step++;
+		else
+			bounded = std::abs(values.front().v() - series.Value(point)) <= options.ValueTolerance() * (1.0 + 1e-9);
+	}
+	ret &= Test(bounded, "Swinging door bound");
+	ret &= Test(step == 2, "Swinging door multivalue point");
+	return ret;
+}
+
+bool TimeSeriesTests::ParallelCompressTest()
+{
+	bool ret{ true };
+	// random walk with the smooth and flat parts and multivalue points
+	TSD series;
+	TSC columns;
+	double value{ 0.0 };
+	uint64_t state{ 12345 };
+	for (size_t i = 0; i < 20000; i++)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		const double random{ static_cast<double>(state >> 11) / 9007199254740992.0 - 0.5 };
+		value += i % 3000 < 1000 ? 1e-3 * random : (i % 3000 < 2000 ? 0.0 : 1e-2 * std::sin(1e-3 * i));
+		series.emplace_back(0.01 * static_cast<double>(i), value);
+		columns.emplace_back(0.01 * static_cast<double>(i), value);
+		if (i % 777 == 0)
+		{
+			series.emplace_back(0.01 * static_cast<double>(i), value + 1.0);
+			columns.emplace_back(0.01 * static_cast<double>(i), value + 1.0);
+		}
+	}
+
+	for (const auto method : { timeseries::CompressMethod::Neighbour, timeseries::CompressMethod::SwingingDoor })
+		for (const double tolerance : { 1e-4, 1e-2 })
+		{
+			TSO options;
+			options.SetCompression(method);
+			options.SetValueTolerance(tolerance);
+			TSD sequential{ series };
+			sequential.Compress(options);
+			bool same{ true };
+			for (const size_t threads : { 2, 3, 8, 0 })
+			{
+				TSD parallel{ series };
+				TSC parallelcolumns{ columns };
+				parallel.Compress(options, threads);
+				parallelcolumns.Compress(options, threads);
+				same &= SameSeries(parallel, sequential) && SameSeries(parallelcolumns, sequential);
+			}
+			ret &= Test(same && sequential.size() < series.size(), fmt::format("Parallel compress {} points", sequential.size()));
+		}
+	return ret;
+}
+
 bool TimeSeriesTests::OverallTest()
 {
 	bool ret{ true };
@@ -162,6 +257,1150 @@ bool TimeSeriesTests::OverallTest()
 	return ret;
 }
  
+bool TimeSeriesTests::CSVTest()
+{
+	bool ret{ true };
+	// reference stream parser
+	const auto path{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	std::ifstream csvfile(path);
+	csvfile.imbue(std::locale(csvfile.getloc(), new timeseries::comma_facet<char, ','>));
+	std::vector<timeseries::PointT<double, double>> reference;
+	double time{ 0 }, value{ 0 };
+	char semicolon{ ';' };
+	for (;;)
+	{
+		csvfile >> time >> semicolon >> value;
+		if (csvfile.eof() || csvfile.fail())
+			break;
+		csvfile.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+		reference.emplace_back(time, value);
+	}
+
+	TSD series(path);
+	ret &= series.size() == reference.size() && !series.empty();
+	for (size_t i = 0; ret && i < reference.size(); i++)
+		ret &= series[i].t() == reference[i].t() && series[i].v() == reference[i].v();
+	ret &= Test(ret, "CSV stream parser match");
+
+	// small blocks force lines to be split across block boundaries
+	TSD blocks;
+	timeseries::CSVReader(path, 7).Read<double, double>([&blocks](const double& t, const double& v)
+		{
+			blocks.emplace_back(t, v);
+		});
+	ret &= Test(blocks.Compare(series, TSO()).Idenctical(), "CSV block boundaries");
+
+	// decimal point and decimal comma
+	const std::string_view text{ "0.5;1,5\n 1 ; -2.5E-1 ;\r\n+1,5;3" };
+	TSD parsed;
+	ret &= timeseries::CSVParser::Parse<double, double>(text.data(), text.data() + text.size(), 
+		[&parsed](const double& t, const double& v)
+		{
+			parsed.emplace_back(t, v);
+		});
+	ret &= Test(parsed.Compare(TSD({ 0.5, 1.0, 1.5 }, { 1.5, -0.25, 3.0 }), TSO()).Idenctical() && parsed.size() == 3,
+		"CSV decimal separators");
+	return ret;
+}
+
+bool TimeSeriesTests::ColumnsTest()
+{
+	bool ret{ true };
+	TSD series1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	TSD series2{ TimeSeriesTests::TestPath("tests/compare2.csv") };
+	TSC columns1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	TSC columns2{ TimeSeriesTests::TestPath("tests/compare2.csv") };
+	TSO options;
+	options.SetMultiValuePoint(timeseries::MultiValuePointProcess::Avg);
+
+	const auto reference{ series1.Compare(series2, options) };
+	ret &= Test(SameResult(reference, columns1.Compare(columns2, options)), "Columns compare");
+	ret &= Test(SameResult(reference, columns1.Compare(series2, options)) && 
+				SameResult(reference, series1.Compare(columns2, options)), "Columns and points compare");
+
+	auto diff{ columns1.Difference(columns2, options) };
+	auto diffref{ series1.Difference(series2, options) };
+	ret &= Test(diff.size() == diffref.size() && diff.Compare(diffref, options).Idenctical(), "Columns difference");
+
+	columns1.Compress(options);
+	series1.Compress(options);
+	ret &= Test(columns1.size() == series1.size() && columns1.Compare(series1, options).Idenctical(), "Columns compress");
+
+	TSC nonmonotonic(TimeSeriesTests::TestPath("tests/nonmonotonic.csv"));
+	ret &= Test(nonmonotonic.IsMonotonic().has_value(), "Columns monotonic");
+	return ret;
+}
+
+bool TimeSeriesTests::MergeCompareTest()
+{
+	bool ret{ true };
+	TSD series1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	TSD series2{ TimeSeriesTests::TestPath("tests/compare2.csv") };
+	TSD monotonic{ TimeSeriesTests::TestPath("tests/monotonic.csv") };
+	TSD multi({ 0, 2, 2, 2.5, 4 }, { 1, 3, 5, 0, 7 });
+
+	// reference compare with union time and point by point search
+	const auto Reference = [](const TSD& lhs, const TSD& rhs, const TSO& options)
+	{
+		TSD::CompareResult comps;
+		auto it1{ lhs.end() };
+		auto it2{ rhs.end() };
+		for (const auto& time : lhs.UnionTime(rhs, options))
+			comps.Update(lhs.GetTimePoints(time, options, it1), rhs.GetTimePoints(time, options, it2), options);
+		return comps.Finish();
+	};
+
+	for (const auto process : { timeseries::MultiValuePointProcess::All, 
+								timeseries::MultiValuePointProcess::Avg, 
+								timeseries::MultiValuePointProcess::Max })
+	{
+		for (const auto tolerance : { 1e-8, 0.05, 0.7 })
+		{
+			TSO options;
+			options.SetMultiValuePoint(process);
+			options.SetTimeTolerance(tolerance);
+			ret &= SameResult(series1.Compare(series2, options), Reference(series1, series2, options));
+			ret &= SameResult(monotonic.Compare(multi, options), Reference(monotonic, multi, options));
+			ret &= SameResult(multi.Compare(monotonic, options), Reference(multi, monotonic, options));
+		}
+	}
+
+	return Test(ret, "Merge compare matches point search");
+}
+
+bool TimeSeriesTests::ParallelCompareTest()
+{
+	bool ret{ true };
+	// several chunks, the second series has multivalue points and the other grid
+	TSD series1, series2;
+	for (size_t i = 0; i < 3 * TSD::CompareResult::ChunkSize + 1234; i++)
+	{
+		const double time{ 0.001 * static_cast<double>(i) };
+		series1.emplace_back(time, std::sin(time));
+		series2.emplace_back(time + 0.0003, std::sin(time + 0.0003) + 1e-4 * std::cos(7.0 * time));
+		if (i % 5000 == 0)
+			series2.emplace_back(time + 0.0003, 0.5);
+	}
+
+	const auto Close = [](const TSD::CompareResult& cr1, const TSD::CompareResult& cr2)
+	{
+		const auto Near = [](double lhs, double rhs)
+		{
+			return std::abs(lhs - rhs) <= 1e-9 * (std::max)(std::abs(lhs), std::abs(rhs));
+		};
+		return cr1.Max().v() == cr2.Max().v() && cr1.Max().t() == cr2.Max().t() &&
+			cr1.Min().v() == cr2.Min().v() && cr1.Min().t() == cr2.Min().t() &&
+			Near(cr1.KSTest(), cr2.KSTest()) && Near(cr1.Sum(), cr2.Sum()) && Near(cr1.SqSum(), cr2.SqSum());
+	};
+
+	// tolerance wider than the step leaves no boundaries for the chunks
+	for (const auto tolerance : { 1e-8, 0.0002, 0.01 })
+	{
+		TSO options;
+		options.SetTimeTolerance(tolerance);
+
+		// whole walk accumulated in the single result
+		TSD::CompareResult whole, first, second;
+		size_t pairs{ 0 };
+		series1.ForEachAligned(series2, options, [&](const double&, const double& t1, const double& v1, const double& v2)
+			{
+				whole.Update(t1, v1, v2, options);
+				(pairs++ < 100000 ? first : second).Update(t1, v1, v2, options);
+			});
+		whole.Finish();
+		ret &= Test(Close(first.Merge(second).Finish(), whole), "Merge");
+
+		const auto serial{ series1.Compare(series2, options) };
+		ret &= Test(Close(serial, whole), "Chunked compare");
+		for (const size_t threads : { 0, 2, 3 })
+			ret &= Test(SameResult(series1.Compare(series2, options, threads), serial), fmt::format("Parallel compare {} threads", threads));
+		ret &= Test(SameResult(series2.Compare(series1, options, 4), series2.Compare(series1, options)), "Parallel compare reversed");
+	}
+	ret &= Test(series1.CompareChunks(series2, TSO()).size() == 5, "Compare chunks");
+
+	// batch of the long pair, which is compared by the chunks, and the short ones coalesced
+	std::vector<TSD> shorts;
+	for (size_t i = 0; i < 40; i++)
+		shorts.emplace_back(TSD({ 0.0, 1.0 + static_cast<double>(i), 50.0 }, { static_cast<double>(i), 2.0, 3.0 }));
+	std::vector<std::pair<const TSD*, const TSD*>> pairs{ { &series1, &series2 } };
+	for (size_t i = 0; i + 1 < shorts.size(); i++)
+		pairs.emplace_back(&shorts[i], i % 3 ? &shorts[i + 1] : &series1);
+	for (const size_t threads : { 1, 0, 3 })
+	{
+		const auto results{ TSD::CompareBatch(pairs, TSO(), threads) };
+		bool same{ results.size() == pairs.size() };
+		for (size_t pair = 0; same && pair < pairs.size(); pair++)
+			same = SameResult(results[pair], pairs[pair].first->Compare(*pairs[pair].second, TSO()));
+		ret &= Test(same, fmt::format("Batch compare {} threads", threads));
+	}
+
+	// out-of-core compare merges the same chunks
+	const auto path1{ std::filesystem::temp_directory_path() / "timeseries_chunks1.tsb" };
+	const auto path2{ std::filesystem::temp_directory_path() / "timeseries_chunks2.tsb" };
+	series1.WriteBinary(path1);
+	series2.WriteBinary(path2);
+	ret &= Test(SameResult(timeseries::CompareFiles(path1, path2, TSO(), 4096), series1.Compare(series2, TSO())), "Out-of-core chunks");
+	std::filesystem::remove(path1);
+	std::filesystem::remove(path2);
+	return ret;
+}
+
+bool TimeSeriesTests::TimePointsTest()
+{
+	bool ret{ true };
+	TSO options;
+	options.SetTimeTolerance(0.05);
+	// discontinuity with more points than inline buffer holds
+	TSD series({ 0, 1, 1, 1, 1, 1, 1, 2 }, { 0, 1, 2, 3, 4, 5, 6, 7 });
+	timeseries::TimePointsT<double, double, 2> points;
+	TSD::fwitT start{ series.end() };
+
+	series.GetTimePoints(0.5, options, start, points);
+	ret &= points.size() == 1 && points.front().v() == 0.5;
+	series.GetTimePoints(1.0, options, start, points);
+	ret &= points.size() == 6;
+	for (size_t i = 0; i < points.size(); i++)
+		ret &= points[i].v() == static_cast<double>(i + 1);
+	series.GetTimePoints(1.5, options, start, points);
+	ret &= points.size() == 1 && points.front().v() == 6.5;
+
+	options.SetMultiValuePoint(timeseries::MultiValuePointProcess::Avg);
+	start = series.end();
+	series.GetTimePoints(1.0, options, start, points);
+	ret &= points.size() == 1 && points.front().v() == 3.5 && points.front().t() == 1.0;
+
+	// buffer and series results match
+	TSD monotonic(TimeSeriesTests::TestPath("tests/monotonic.csv"));
+	options.SetMultiValuePoint(timeseries::MultiValuePointProcess::All);
+	TSD::fwitT start1{ monotonic.end() }, start2{ monotonic.end() };
+	for (double t = -1.0; t < 6.0; t += 0.01)
+	{
+		const auto pr{ monotonic.GetTimePoints(t, options, start1) };
+		monotonic.GetTimePoints(t, options, start2, points);
+		ret &= pr.size() == points.size() && std::equal(pr.begin(), pr.end(), points.begin(), 
+			[](const auto& lhs, const auto& rhs) { return lhs.t() == rhs.t() && lhs.v() == rhs.v(); });
+	}
+
+	return ret;
+}
+
+bool TimeSeriesTests::GallopTest()
+{
+	bool ret{ true };
+	// steps of different lengths and multivalue points
+	timeseries::TimeSeriesColumnsT<double, double> columns;
+	TSD series;
+	double time{ 0.0 };
+	for (size_t i = 0; i < 3000; i++)
+	{
+		columns.emplace_back(time, static_cast<double>(i));
+		series.emplace_back(time, static_cast<double>(i));
+		if (i % 7 != 0)
+			time += 0.001 * static_cast<double>(i % 13);
+	}
+
+	bool bounds{ true };
+	for (size_t first = 0; bounds && first <= columns.size(); first += 37)
+		for (double t = -1.0; bounds && t < time + 1.0; t += 0.0731)
+			bounds = timeseries::GallopLowerBound(columns, first, t) == columns.LowerBound(first, t);
+	ret &= Test(bounds, "Gallop bounds");
+
+	// sparse and dense walks give the same slots as the search from the beginning
+	TSO options;
+	options.SetTimeTolerance(0.002);
+	for (const double step : { 0.0003, 0.5, 77.0 })
+	{
+		timeseries::TimeCursor<double, timeseries::TimeSeriesColumnsT<double, double>> cursor(columns);
+		TSD::fwitT start{ series.end() };
+		bool slots{ true };
+		for (double t = -1.0; slots && t < time + 1.0; t += step)
+		{
+			const auto slot{ cursor.Seek(t, options.TimeTolerance()) };
+			const auto left{ columns.LowerBound(0, t - options.TimeTolerance()) };
+			slots = slot.First == left && slot.Count == columns.LowerBound(0, t + options.TimeTolerance()) - left;
+			const auto hinted{ series.GetTimePoints(t, options, start) }, searched{ series.GetTimePoints(t, options) };
+			slots &= hinted.size() == searched.size() && hinted.front().v() == searched.front().v();
+		}
+		ret &= Test(slots, "Gallop cursor");
+	}
+	return ret;
+}
+
+bool TimeSeriesTests::EvaluateTest()
+{
+	bool ret{ true };
+	TSD series{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	TSC columns{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	// times before, inside and after the series, some of them repeated and at the points
+	std::vector<double> times;
+	for (double t = series.Time(0) - 1.0; t < series.Time(series.size() - 1) + 1.0; t += 0.0137)
+		times.push_back(t);
+	for (size_t i = 0; i < series.size(); i += 5)
+		times.push_back(series.Time(i));
+	times.push_back(times.back());
+	std::sort(times.begin(), times.end());
+
+	for (const auto process : { timeseries::MultiValuePointProcess::All, timeseries::MultiValuePointProcess::Avg })
+	{
+		TSO options;
+		options.SetMultiValuePoint(process);
+		const auto values{ series.Evaluate(times, options) }, cvalues{ columns.Evaluate(times, options) };
+		bool same{ values.size() == times.size() && values == cvalues };
+		for (size_t i = 0; same && i < times.size(); i++)
+			same = series.GetTimePoints(times[i], options).back().v() == values[i];
+		ret &= Test(same, "Evaluate");
+	}
+
+	using MCS = timeseries::MultiChannelSeriesT<double, double>;
+	MCS channels(2);
+	for (const auto& point : series)
+	{
+		const double values[2] = { point.v(), 2.0 * point.v() };
+		channels.emplace_back(point.t(), values);
+	}
+	TSO options;
+	const auto values{ channels.Evaluate(times, options) };
+	ret &= Test(values.size() == 2 && values[0] == series.Evaluate(times, options) && 
+		values[1] == channels.Channel(1).Evaluate(times, options), "Evaluate channels");
+
+	try
+	{
+		std::reverse(times.begin(), times.end());
+		series.Evaluate(times, options);
+		ret &= Test(false, "Evaluate descending");
+	}
+	catch (const timeseries::Exception&) {}
+
+	return ret;
+}
+
+bool TimeSeriesTests::InterpolationTest()
+{
+	bool ret{ true };
+	TSO options;
+	const auto At = [&options](const auto& series, double t) { return series.GetTimePoints(t, options).front().v(); };
+
+	// hold takes the last value before the time
+	TSI<timeseries::HoldInterpolationT> hold({ 0, 1, 2 }, { 0, 10, 20 });
+	ret &= Test(At(hold, -1.0) == 0.0 && At(hold, 0.5) == 0.0 && At(hold, 1.5) == 10.0 && At(hold, 3.0) == 20.0, "Interpolation hold");
+
+	// cubics reproduce the line and pass through the points
+	TSI<timeseries::PchipInterpolationT> pchipline({ 0, 1, 3, 4 }, { 1, 3, 7, 9 });
+	TSI<timeseries::SplineInterpolationT> splineline({ 0, 1, 3, 4 }, { 1, 3, 7, 9 });
+	bool line{ true };
+	for (double t = -0.5; t < 4.5; t += 0.25)
+		line &= std::abs(At(pchipline, t) - (2 * t + 1)) < 1e-12 && std::abs(At(splineline, t) - (2 * t + 1)) < 1e-12;
+	ret &= Test(line, "Interpolation cubic line");
+
+	// smooth signal: spline is much closer than linear, pchip does not overshoot the steps
+	TSD linear;
+	TSI<timeseries::SplineInterpolationT> spline;
+	TSI<timeseries::PchipInterpolationT> pchip;
+	for (double t = 0.0; t <= 6.0; t += 0.5)
+	{
+		linear.emplace_back(t, std::sin(t));
+		spline.emplace_back(t, std::sin(t));
+		pchip.emplace_back(t, t < 3.0 ? 0.0 : 1.0);
+	}
+	double linearerror{ 0 }, splineerror{ 0 };
+	bool monotone{ true };
+	for (double t = 0.5; t < 5.5; t += 0.01)
+	{
+		linearerror = (std::max)(linearerror, std::abs(At(linear, t) - std::sin(t)));
+		splineerror = (std::max)(splineerror, std::abs(At(spline, t) - std::sin(t)));
+		monotone &= At(pchip, t) >= 0.0 && At(pchip, t) <= 1.0 && At(pchip, t) <= At(pchip, t + 0.01);
+	}
+	ret &= Test(splineerror < linearerror / 5 && monotone, "Interpolation smooth");
+
+	// discontinuity splits the runs, batch evaluation gives the same values
+	TSI<timeseries::SplineInterpolationT> jump({ 0, 1, 2, 2, 3, 4 }, { 0, 1, 2, 10, 11, 12 });
+	const auto points{ jump.GetTimePoints(2.0, options) };
+	std::vector<double> times;
+	for (double t = -1.0; t < 5.0; t += 0.125)
+		times.push_back(t);
+	const auto values{ jump.Evaluate(times, options) };
+	bool batch{ true };
+	for (size_t i = 0; i < times.size(); i++)
+		batch &= values[i] == jump.GetTimePoints(times[i], options).back().v();
+	ret &= Test(points.size() == 2 && std::abs(At(jump, 1.5) - 1.5) < 1e-12 && std::abs(At(jump, 2.5) - 10.5) < 1e-12 && batch,
+		"Interpolation discontinuity");
+
+	// series with different policies are compared
+	const auto comps{ hold.Compare(TSD({ 0, 1, 2 }, { 0, 10, 20 }), options) };
+	ret &= Test(comps.Max().v() == 0.0, "Interpolation compare");
+
+	// coefficients are computed again after the points are changed with the same count
+	TSI<timeseries::SplineInterpolationT> changed({ 0, 1, 2, 3 }, { 0, 1, 2, 3 });
+	const double before{ At(changed, 1.5) };
+	changed.Set(2, 2.0, 5.0);
+	const TSI<timeseries::SplineInterpolationT> reference({ 0, 1, 2, 3 }, { 0, 1, 5, 3 });
+	ret &= Test(std::abs(before - 1.5) < 1e-12 && At(changed, 1.5) == At(reference, 1.5), "Interpolation changed points");
+	return ret;
+}
+
+bool TimeSeriesTests::CompareKernelTest()
+{
+	bool ret{ true };
+	// blocks with the tails of different lengths, the spike is in the middle of the block
+	const size_t count{ 3 * timeseries::CompareResultT<double, double>::BlockSize + 7 };
+	std::vector<double> times(count), values1(count), values2(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		times[i] = 0.01 * static_cast<double>(i);
+		values1[i] = std::sin(times[i]);
+		values2[i] = values1[i] + 1e-4 * std::cos(3.0 * times[i]) + (i == 1500 ? 0.1 : 0.0);
+	}
+	TSO options;
+
+	// straightforward sequential accumulation
+	double max{ 0.0 }, min{ 0.0 }, ks{ 0.0 }, ksmax{ 0.0 }, sum{ 0.0 }, sqsum{ 0.0 };
+	size_t maxindex{ 0 }, minindex{ 0 };
+	for (size_t i = 0; i < count; i++)
+	{
+		const double diff{ values1[i] - values2[i] };
+		const double awd{ std::abs(diff / (options.Rtol() * std::abs((std::max)(values1[i], values2[i])) + options.Atol())) };
+		if (i == 0 || max < awd)
+		{
+			max = awd;
+			maxindex = i;
+		}
+		if (i == 0 || min > awd)
+		{
+			min = awd;
+			minindex = i;
+		}
+		ks += diff;
+		ksmax = (std::max)(ksmax, std::abs(ks));
+		sum += diff;
+		sqsum += diff * diff;
+	}
+
+	const auto Close = [](double lhs, double rhs)
+	{
+		return std::abs(lhs - rhs) <= 1e-12 * (std::max)(std::abs(lhs), std::abs(rhs));
+	};
+
+	timeseries::CompareResultT<double, double> block, single;
+	block.Update(times.data(), values1.data(), values2.data(), count, options);
+	block.Finish();
+	for (size_t i = 0; i < count; i++)
+		single.Update(times[i], values1[i], values2[i], options);
+	single.Finish();
+
+	ret &= Test(block.Max().v() == max && block.Max().t() == times[maxindex] &&
+				block.Min().v() == min && block.Min().t() == times[minindex], "Kernel extremes");
+	ret &= Test(Close(block.KSTest(), ksmax) && Close(block.Sum(), sum) && Close(block.SqSum(), sqsum) &&
+				Close(block.Avg(), sum / static_cast<double>(count)), "Kernel sums");
+	ret &= Test(block.Max().t() == single.Max().t() && block.KSTest() == single.KSTest() &&
+				block.Sum() == single.Sum() && block.SqSum() == single.SqSum(), "Kernel single update");
+
+	// generic path of the kernel
+	timeseries::CompareResultT<float, float> generic;
+	timeseries::TimeSeriesOptionsT<float, float> floatoptions;
+	for (size_t i = 0; i < count; i++)
+		generic.Update(static_cast<float>(times[i]), static_cast<float>(values1[i]), static_cast<float>(values2[i]), floatoptions);
+	generic.Finish();
+	ret &= Test(std::abs(generic.Max().t() - times[maxindex]) < 1e-4, "Kernel generic");
+
+	// accessors see the pending pairs before Finish
+	timeseries::CompareResultT<double, double> pending;
+	for (size_t i = 0; i < 1501; i++)
+		pending.Update(times[i], values1[i], values2[i], options);
+	ret &= Test(pending.Max().t() == times[1500] && pending.Min().t() == single.Min().t() && pending.Sum() != 0.0, "Kernel pending pairs");
+
+	// tolerances are applied to the pairs updated with them
+	TSO loose;
+	loose.SetAtol(1e3);
+	timeseries::CompareResultT<double, double> mixed;
+	for (size_t i = 0; i < count; i++)
+		mixed.Update(times[i], values1[i], values2[i], i == 1500 ? options : loose);
+	ret &= Test(mixed.Max().t() == times[1500] && Close(mixed.Max().v(), max), "Kernel tolerances per pair");
+	return ret;
+}
+
+bool TimeSeriesTests::UniformTest()
+{
+	bool ret{ true };
+	TSO options;
+	options.SetMultiValuePoint(timeseries::MultiValuePointProcess::Avg);
+	TSD series(TimeSeriesTests::TestPath("tests/monotonic.csv"));
+	const auto dense{ series.DenseOutput(-1.0, 6.0, 0.01, options) };
+	const auto uniform{ series.DenseOutput<TSUniform>(-1.0, 6.0, 0.01, options) };
+	ret &= Test(dense.size() == uniform.size() && uniform.Compare(dense, options).Idenctical() && 
+		uniform.Step() == 0.01 && uniform.Start() == -1.0, "Uniform dense output");
+
+	// the uniform grid can't hold every value of the multivalue point
+	TSD multi;
+	multi.emplace_back(0.0, 1.0);
+	multi.emplace_back(1.0, 2.0);
+	multi.emplace_back(1.0, 4.0);
+	multi.emplace_back(2.0, 3.0);
+	TSO all;
+	ret &= Test(multi.DenseOutput(0.0, 2.0, 1.0, all).size() == 4, "Dense output all values");
+	try
+	{
+		multi.DenseOutput<TSUniform>(0.0, 2.0, 1.0, all);
+		ret &= Test(false, "Uniform dense output all values");
+	}
+	catch (const timeseries::Exception&) {}
+	const auto reduced{ multi.DenseOutput<TSUniform>(0.0, 2.0, 1.0, options) };
+	ret &= Test(reduced.size() == 3 && reduced[1].v() == 3.0, "Uniform dense output reduced values");
+
+	// computed lookup matches search
+	TSO tolerance;
+	tolerance.SetTimeTolerance(0.003);
+	TSD::fwitT start1{ dense.end() };
+	TSU::fwitT start2{ uniform.end() };
+	timeseries::TimePointsT<double, double> points1, points2;
+	bool match{ true };
+	for (double t = -1.5; t < 6.5; t += 0.0037)
+	{
+		dense.GetTimePoints(t, tolerance, start1, points1);
+		uniform.GetTimePoints(t, tolerance, start2, points2);
+		match &= points1.size() == points2.size() && points1.front().t() == points2.front().t() &&
+			points1.front().v() == points2.front().v();
+	}
+	ret &= Test(match, "Uniform time points");
+
+	const auto diff{ uniform.Difference(series, options) };
+	ret &= Test(diff.Compare(dense.Difference(series, options), options).Idenctical(), "Uniform difference");
+
+	// union times of the off grid series with multivalue points
+	TSD offgrid;
+	for (const auto& [t, v] : { std::pair{ -0.5, 1.0 }, { 1.7, 2.0 }, { 1.7, 5.0 }, { 2.333, 3.0 }, { 7.0, 4.0 } })
+		offgrid.emplace_back(t, v);
+	ret &= Test(SameSeries(uniform.Difference(offgrid, options), dense.Difference(offgrid, options)), "Uniform difference off grid");
+
+	// points kept by the compression don't fit the grid
+	try
+	{
+		TSU compressed(TSUniform(0.0, 1.0, { 0.0, 1.0, 2.0, 3.0, 4.0, 4.0, 4.0, 4.0, 4.0, 9.0 }));
+		compressed.Compress(options);
+		ret &= Test(false, "Uniform compress");
+	}
+	catch (const timeseries::Exception&) {}
+
+	TSU kstest(TimeSeriesTests::TestPath("tests/kstest1.csv"));
+	ret &= Test(kstest.Step() == 1.0 && kstest.size() == 25, "Uniform from CSV");
+
+	try
+	{
+		TSU offgrid(TSUniform(0.0, 0.5));
+		offgrid.emplace_back(0.0, 1.0);
+		offgrid.emplace_back(0.7, 1.0);
+		ret &= Test(false, "Uniform off grid");
+	}
+	catch (const timeseries::Exception&) {}
+
+	return ret;
+}
+
+bool TimeSeriesTests::MultiChannelTest()
+{
+	bool ret{ true };
+	TSD series1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	TSD series2{ TimeSeriesTests::TestPath("tests/compare2.csv") };
+	using MCS = timeseries::MultiChannelSeriesT<double, double>;
+
+	// channels are scaled and shifted source series
+	const auto Channels = [](const TSD& series)
+	{
+		MCS channels(3);
+		for (const auto& point : series)
+		{
+			const double values[3] = { point.v(), 2.0 * point.v(), point.v() + 1.0 };
+			channels.emplace_back(point.t(), values);
+		}
+		return channels;
+	};
+
+	const auto channels1{ Channels(series1) }, channels2{ Channels(series2) };
+	TSO options;
+	options.SetMultiValuePoint(timeseries::MultiValuePointProcess::Avg);
+	const auto results{ channels1.Compare(channels2, options) };
+	ret &= results.size() == 3;
+	for (size_t channel = 0; ret && channel < results.size(); channel++)
+	{
+		const auto reference{ channels1.Channel(channel).Compare(channels2.Channel(channel), options) };
+		ret &= SameResult(results[channel], reference);
+	}
+	ret &= results.front().Max().v() == series1.Compare(series2, options).Max().v();
+	ret &= Test(ret, "Multichannel compare");
+
+	// series longer than the chunk are compared by chunks as the channel series are
+	TSD long1, long2;
+	for (size_t i = 0; i < 2 * TSD::CompareResult::ChunkSize + 345; i++)
+	{
+		long1.emplace_back(0.01 * static_cast<double>(i), std::sin(0.01 * static_cast<double>(i)));
+		if (i % 5 != 0)
+			long2.emplace_back(0.01 * static_cast<double>(i) + 0.003, std::sin(0.01 * static_cast<double>(i)) + 1e-3 * std::cos(0.3 * i));
+	}
+	const auto longchannels1{ Channels(long1) }, longchannels2{ Channels(long2) };
+	const auto longresults{ longchannels1.Compare(longchannels2, options) };
+	bool same{ longresults.size() == 3 };
+	for (size_t channel = 0; same && channel < longresults.size(); channel++)
+	{
+		const auto reference{ longchannels1.Channel(channel).Compare(longchannels2.Channel(channel), options) };
+		same = SameResult(longresults[channel], reference);
+	}
+	ret &= Test(same, "Multichannel compare chunks");
+	return ret;
+}
+
+bool TimeSeriesTests::MultiColumnTest()
+{
+	bool ret{ true };
+	using MCS = timeseries::MultiChannelSeriesT<double, double>;
+	const auto path{ TimeSeriesTests::TestPath("tests/multicolumn.csv") };
+	const auto header{ timeseries::CSVReader(path).Header() };
+	ret &= Test(header == std::vector<std::string>{ "a", "b", "c" }, "Multicolumn header");
+
+	MCS projected(path, std::vector<size_t>{ 2, 0 });
+	ret &= projected.Channels() == 2 && projected.size() == 3;
+	for (size_t i = 0; ret && i < projected.size(); i++)
+		ret &= projected.Time(i) == 0.5 * i && 
+			   projected.Value(0, i) == 100.0 * (i + 1) && 
+			   projected.Value(1, i) == 1.5 + i;
+	ret &= Test(ret, "Multicolumn projection");
+
+	bool thrown{ false };
+	try
+	{
+		MCS duplicate(path, std::vector<size_t>{ 1, 1 });
+	}
+	catch (const timeseries::Exception&)
+	{
+		thrown = true;
+	}
+	ret &= Test(thrown, "Multicolumn duplicate column");
+
+	MCS named(path, std::vector<std::string>{ "b" });
+	TSD column(path, 1);
+	ret &= Test(named.Channels() == 1 && named.Channel(0).Compare(column, TSO()).Idenctical() && 
+		column.size() == 3 && column.back().v() == 30.0, "Multicolumn names");
+
+	try
+	{
+		MCS missing(path, std::vector<std::string>{ "d" });
+		ret &= Test(false, "Multicolumn missing name");
+	}
+	catch (const timeseries::Exception&) {}
+
+	return ret;
+}
+
+bool TimeSeriesTests::ParallelCSVTest()
+{
+	bool ret{ true };
+	// file large enough to be split to several chunks
+	const auto path{ std::filesystem::temp_directory_path() / "timeseries_parallel.csv" };
+	const auto write = [&path](size_t Malformed, size_t Reversed)
+	{
+		std::ofstream csv(path);
+		for (size_t i = 0; i < 100000; i++)
+			if (i == Malformed)
+				csv << "malformed\n";
+			else
+				csv << (i == Reversed ? 0.0 : 0.01 * i) << ";" << i << ",5\n";
+	};
+
+	TSD::LoadOptions options;
+	options.SetThreads(4);
+
+	write(100000, 100000);
+	TSD sequential(path), parallel(path, options);
+	ret &= Test(parallel.size() == 100000 && sequential.Compare(parallel, TSO()).Idenctical() &&
+		parallel.back().v() == 99999.5, "Parallel CSV");
+
+	write(70000, 100000);
+	ret &= Test(TSD(path, options).size() == 70000, "Parallel CSV stops on malformed record");
+
+	write(100000, 90000);
+	TSD nonmonotonic(path, options);
+	const auto sequentialcheck{ nonmonotonic.IsMonotonic() }, parallelcheck{ nonmonotonic.IsMonotonic(4) };
+	ret &= Test(parallelcheck.has_value() && sequentialcheck.has_value() &&
+		parallelcheck->first.t() == sequentialcheck->first.t() &&
+		parallelcheck->second.t() == sequentialcheck->second.t(), "Parallel IsMonotonic");
+	try
+	{
+		nonmonotonic.Check();
+		ret &= Test(false, "Parallel CSV non-monotonic");
+	}
+	catch (const timeseries::Exception&) {}
+
+	std::filesystem::remove(path);
+	return ret;
+}
+
+bool TimeSeriesTests::BinaryTest()
+{
+	bool ret{ true };
+	const auto path{ std::filesystem::temp_directory_path() / "timeseries_binary.tsb" };
+	TSD series1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	TSD series2{ TimeSeriesTests::TestPath("tests/compare2.csv") };
+	series1.WriteBinary(path);
+
+	{
+		const timeseries::BinaryView<double, double> view(path);
+		ret &= Test(view.size() == series1.size() && 
+			view.Header().TimeMin == series1.front().t() && 
+			view.Header().TimeMax == series1.back().t(), "Binary header");
+
+		TSD loaded(path);
+		TSM mapped(path);
+		TSO options;
+		options.SetMultiValuePoint(timeseries::MultiValuePointProcess::Avg);
+		const auto reference{ series1.Compare(series2, options).Finish() };
+		const auto fromfile{ mapped.Compare(series2, options).Finish() };
+		ret &= Test(loaded.size() == series1.size() && loaded.Compare(series1, TSO()).Idenctical() &&
+			mapped.size() == series1.size() && mapped.Compare(series1, TSO()).Idenctical() &&
+			fromfile.KSTest() == reference.KSTest() && fromfile.Max().v() == reference.Max().v(), "Binary load and map");
+
+		const auto time{ series1[series1.size() / 2].t() };
+		const auto points{ mapped.GetTimePoints(time, TSO()) }, expected{ series1.GetTimePoints(time, TSO()) };
+		ret &= Test(points.size() == expected.size() && points.front().v() == expected.front().v(), "Binary time points");
+	}
+
+	try
+	{
+		timeseries::TimeSeries<double, float> mismatch(path);
+		ret &= Test(false, "Binary type mismatch");
+	}
+	catch (const timeseries::Exception&) {}
+
+	try
+	{
+		TSM csv{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+		ret &= Test(false, "Binary map of CSV");
+	}
+	catch (const timeseries::Exception&) {}
+
+	std::filesystem::remove(path);
+	return ret;
+}
+
+bool TimeSeriesTests::GorillaTest()
+{
+	bool ret{ true };
+	const auto path{ std::filesystem::temp_directory_path() / "timeseries_gorilla.tsg" };
+
+	// bit exact round trip
+	TSD series1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	series1.WriteGorilla(path);
+	ret &= Test(SameSeries(series1, TSD(path)), "Gorilla round trip");
+
+	// smooth waveform with steps, jumps and special values
+	TSD wave;
+	for (size_t i = 0; i < 100000; i++)
+		wave.emplace_back(-1.0 + 1e-4 * i + (i > 50000 ? 1e3 : 0.0), 
+			i == 70000 ? -0.0 : i == 70001 ? std::numeric_limits<double>::infinity() : std::sin(1e-3 * i) + 0.5 * std::cos(3e-4 * i));
+	wave.WriteGorilla(path);
+	ret &= Test(SameSeries(wave, TSD(path)), "Gorilla waveform round trip");
+	// times take few bits, values are at least a third less than raw doubles
+	ret &= Test(3 * std::filesystem::file_size(path) < 2 * wave.size() * (sizeof(double) + sizeof(double)), "Gorilla footprint");
+
+	using TSF = timeseries::TimeSeries<float, float>;
+	TSF floats;
+	for (size_t i = 0; i < 1000; i++)
+		floats.emplace_back(0.01f * i, static_cast<float>(i % 7));
+	floats.WriteGorilla(path);
+	ret &= Test(SameSeries(floats, TSF(path)), "Gorilla float round trip");
+
+	try
+	{
+		TSD mismatch(path);
+		ret &= Test(false, "Gorilla type mismatch");
+	}
+	catch (const timeseries::Exception&) {}
+
+	// the count of the header does not fit the file
+	for (const uint64_t count : { uint64_t{ 1 } << 60, uint64_t{ 10000 } })
+	{
+		floats.WriteGorilla(path);
+		{
+			std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(offsetof(timeseries::GorillaHeader, Count));
+			file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		}
+		bool thrown{ false };
+		try
+		{
+			TSF corrupted(path);
+		}
+		catch (const timeseries::Exception&)
+		{
+			thrown = true;
+		}
+		ret &= Test(thrown, fmt::format("Gorilla corrupted count {}", count));
+	}
+
+	std::filesystem::remove(path);
+	return ret;
+}
+
+bool TimeSeriesTests::CSVWriterTest()
+{
+	bool ret{ true };
+	const auto path{ std::filesystem::temp_directory_path() / "timeseries_writer.csv" };
+	TSD series1{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+
+	// shortest form reads back exactly with both separators
+	series1.WriteCSV(path);
+	TSD comma(path);
+	series1.WriteCSV(path, '.');
+	TSD point(path);
+	bool exact{ comma.size() == series1.size() && point.size() == series1.size() };
+	for (size_t i = 0; exact && i < series1.size(); i++)
+		exact = comma.Time(i) == series1.Time(i) && comma.Value(i) == series1.Value(i) &&
+				point.Time(i) == series1.Time(i) && point.Value(i) == series1.Value(i);
+	ret &= Test(exact, "CSV writer round trip");
+
+	TSD third{ {0.0, 1.0}, {1.0 / 3.0, 2.0 / 3.0} };
+	third.WriteCSV(path, '.', 3);
+	std::ifstream csvfile(path);
+	std::string line1, line2;
+	std::getline(csvfile, line1);
+	std::getline(csvfile, line2);
+	ret &= Test(line1 == "0;0.333" && line2 == "1;0.667", "CSV writer precision");
+	csvfile.close();
+
+	try
+	{
+		third.WriteCSV(std::filesystem::temp_directory_path() / "missing_directory" / "file.csv");
+		ret &= Test(false, "CSV writer open failure");
+	}
+	catch (const timeseries::Exception&) {}
+
+	std::filesystem::remove(path);
+	return ret;
+}
+
+bool TimeSeriesTests::DenseRangeTest()
+{
+	bool ret{ true };
+	const auto csvpath{ std::filesystem::temp_directory_path() / "timeseries_dense.csv" };
+	const auto binpath{ std::filesystem::temp_directory_path() / "timeseries_dense.tsb" };
+	TSD series1(TimeSeriesTests::TestPath("tests/monotonic.csv"));
+	TSD series2(TimeSeriesTests::TestPath("tests/compare2.csv"));
+	// multiple points at the same time are kept with the default options
+	TSO options;
+	const auto dense{ series1.DenseOutput(-1.0, 6.0, 0.01, options) };
+	const auto range{ series1.DenseOutputRange(-1.0, 6.0, 0.01, options) };
+
+	size_t count{ 0 };
+	bool same{ true };
+	for (const auto& point : range)
+	{
+		same &= count < dense.size() && point.t() == dense.Time(count) && point.v() == dense.Value(count);
+		count++;
+	}
+	ret &= Test(same && count == dense.size() && count > 701, "Dense range");
+
+	timeseries::CSVWriter csv(csvpath);
+	range.WriteTo(csv).Close();
+	timeseries::BinaryWriterT<double, double> binary(binpath);
+	range.WriteTo(binary).Close();
+	ret &= Test(TSD(csvpath).Compare(dense, options).Idenctical() && TSD(binpath).Compare(dense, options).Idenctical() &&
+		!std::filesystem::exists(std::filesystem::path(binpath).concat(".values")), "Dense range to files");
+
+	// the temporary file is removed when the writer fails
+	const auto dirpath{ std::filesystem::temp_directory_path() / "timeseries_writer_dir" };
+	std::filesystem::create_directory(dirpath);
+	bool failed{ false };
+	try
+	{
+		timeseries::BinaryWriterT<double, double> writer(dirpath);
+	}
+	catch (const timeseries::Exception&)
+	{
+		failed = true;
+	}
+	ret &= Test(failed && !std::filesystem::exists(std::filesystem::path(dirpath).concat(".values")), "Binary writer error cleanup");
+	std::filesystem::remove(dirpath);
+
+	// the header is not written when the values are lost
+	failed = false;
+	try
+	{
+		timeseries::BinaryWriterT<double, double> writer(binpath);
+		range.WriteTo(writer);
+		std::filesystem::remove(std::filesystem::path(binpath).concat(".values"));
+		writer.Close();
+	}
+	catch (const timeseries::Exception&)
+	{
+		failed = true;
+	}
+	ret &= Test(failed && !timeseries::BinaryView<double, double>::Is(binpath), "Binary writer lost values");
+
+	// compare at the dense times matches compare of the dense outputs on the same grid
+	const auto dense2{ series2.DenseOutput(-1.0, 6.0, 0.01, options) };
+	TSD::CompareSink sink(dense2, options);
+	const auto fromsink{ range.WriteTo(sink).Result() };
+	const auto reference{ dense.Compare(dense2, options).Finish() };
+	ret &= Test(fromsink.KSTest() == reference.KSTest() && fromsink.Max().v() == reference.Max().v() &&
+		fromsink.Sum() == reference.Sum(), "Dense range compare");
+
+	std::filesystem::remove(csvpath);
+	std::filesystem::remove(binpath);
+	return ret;
+}
+
+bool TimeSeriesTests::CompareFilesTest()
+{
+	bool ret{ true };
+	const auto path1{ TimeSeriesTests::TestPath("tests/compare1.csv") }, path2{ TimeSeriesTests::TestPath("tests/compare2.csv") };
+	const auto binpath{ std::filesystem::temp_directory_path() / "timeseries_outofcore.tsb" };
+	const auto gorillapath{ std::filesystem::temp_directory_path() / "timeseries_outofcore.tsg" };
+	TSD series1(path1), series2(path2);
+	series1.WriteBinary(binpath);
+	series2.WriteGorilla(gorillapath);
+
+	for (const auto process : { timeseries::MultiValuePointProcess::All, timeseries::MultiValuePointProcess::Avg })
+	{
+		TSO options;
+		options.SetMultiValuePoint(process);
+		const auto reference{ series1.Compare(series2, options) };
+		// small window makes the files to be read by many blocks
+		ret &= Test(SameResult(timeseries::CompareFiles(path1, path2, options, 16), reference) &&
+			SameResult(timeseries::CompareFiles(binpath, gorillapath, options, 16), reference) &&
+			SameResult(timeseries::CompareFiles(path1, gorillapath, options), reference), "Out-of-core compare");
+	}
+
+	// series longer than the chunk are compared by chunks, the windows are
+	// smaller than the chunk and the range starts far from the beginning
+	const auto bigpath1{ std::filesystem::temp_directory_path() / "timeseries_outofcore1.csv" };
+	const auto bigpath2{ std::filesystem::temp_directory_path() / "timeseries_outofcore2.csv" };
+	TSD big1, big2;
+	const size_t bigsize{ 3 * TSD::CompareResult::ChunkSize + 1234 };
+	for (size_t i = 0; i < bigsize; i++)
+	{
+		big1.emplace_back(0.001 * static_cast<double>(i), std::sin(0.001 * static_cast<double>(i)));
+		if (i % 3 != 0)
+			big2.emplace_back(0.001 * static_cast<double>(i) + 0.0005, std::sin(0.001 * static_cast<double>(i)) + 1e-3 * std::cos(0.1 * i));
+		// multivalue points
+		if (i % 1000 == 0)
+			big1.emplace_back(0.001 * static_cast<double>(i), 0.0);
+	}
+	big1.WriteCSV(bigpath1);
+	big2.WriteCSV(bigpath2);
+	const TSD loaded1(bigpath1), loaded2(bigpath2);
+	for (const bool range : { false, true })
+	{
+		TSO options;
+		if (range)
+			options.SetRange({ 150.0, 160.0 });
+		ret &= Test(SameResult(timeseries::CompareFiles(bigpath1, bigpath2, options, 1024), loaded1.Compare(loaded2, options)) &&
+			SameResult(timeseries::CompareFiles(bigpath2, bigpath1, options, 1024), loaded2.Compare(loaded1, options)),
+			range ? "Out-of-core compare range" : "Out-of-core compare chunks");
+	}
+	std::filesystem::remove(bigpath1);
+	std::filesystem::remove(bigpath2);
+
+	try
+	{
+		timeseries::CompareFiles(TimeSeriesTests::TestPath("tests/nonmonotonic.csv"), path2, TSO());
+		ret &= Test(false, "Out-of-core compare non-monotonic");
+	}
+	catch (const timeseries::Exception&) {}
+
+	std::filesystem::remove(binpath);
+	std::filesystem::remove(gorillapath);
+	return ret;
+}
+
+bool TimeSeriesTests::ViewTest()
+{
+	bool ret{ true };
+	TSD series1(TimeSeriesTests::TestPath("tests/compare1.csv"));
+	TSD series2(TimeSeriesTests::TestPath("tests/compare2.csv"));
+	TSO options;
+	options.SetMultiValuePoint(timeseries::MultiValuePointProcess::Avg);
+
+	// columns and array of structures owned by the application
+	std::vector<double> times, values;
+	struct State
+	{
+		double value;
+		int flags;
+		double time;
+	};
+	std::vector<State> states;
+	for (size_t i = 0; i < series1.size(); i++)
+	{
+		times.push_back(series1.Time(i));
+		values.push_back(series1.Value(i));
+		states.push_back({ series1.Value(i), 0, series1.Time(i) });
+	}
+
+	TSV columns(times.size(), times.data(), values.data());
+	TSV strided(TSView(states.size(), &states.front().time, sizeof(State), &states.front().value, sizeof(State)));
+
+	const auto reference{ series1.Compare(series2, options) };
+	ret &= Test(columns.Compare(series2, options).KSTest() == reference.KSTest() &&
+		strided.Compare(series2, options).KSTest() == reference.KSTest() &&
+		strided.Compare(series1, options).Idenctical() && !strided.IsMonotonic().has_value(), "View compare");
+
+	const auto time{ series1.Time(series1.size() / 2) + 1e-3 };
+	ret &= Test(strided.GetTimePoints(time, options).front().v() == series1.GetTimePoints(time, options).front().v() &&
+		strided.Difference(series2, options).Compare(series1.Difference(series2, options), options).Idenctical() &&
+		strided.DenseOutput(0.0, 1.0, 0.01, options).Compare(series1.DenseOutput(0.0, 1.0, 0.01, options), options).Idenctical(), "View operations");
+
+	// the view refers to the data of the application
+	values[0] += 1.0;
+	states[1].value += 1.0;
+	ret &= Test(columns.Value(0) == values[0] && strided.Value(1) == states[1].value, "View does not copy");
+
+	return ret;
+}
+
+bool TimeSeriesTests::LoadRangeTest()
+{
+	bool ret{ true };
+	const auto path{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	const auto binpath{ std::filesystem::temp_directory_path() / "timeseries_range.tsb" };
+	const auto gorillapath{ std::filesystem::temp_directory_path() / "timeseries_range.tsg" };
+	TSD series(path);
+	series.WriteBinary(binpath);
+	series.WriteGorilla(gorillapath);
+
+	const double begin{ series.Time(series.size() / 3) }, end{ series.Time(2 * series.size() / 3) };
+	for (const size_t decimation : { 1, 3 })
+	{
+		TSD expected;
+		size_t counter{ 0 };
+		for (size_t i = 0; i < series.size(); i++)
+			if (series.Time(i) >= begin && series.Time(i) < end && counter++ % decimation == 0)
+				expected.emplace_back(series.Time(i), series.Value(i));
+
+		TSD::LoadOptions options;
+		options.SetRange({ begin, end });
+		options.SetDecimation(decimation);
+		const auto Same = [&expected](const auto& loaded) { return SameSeries(loaded, expected); };
+		ret &= Test(expected.size() > 0 && Same(TSD(path, options)) && Same(TSD(binpath, options)) && 
+			Same(TSM(binpath, options)) && Same(TSD(gorillapath, options)), "Load range");
+	}
+
+	TSD::LoadOptions options;
+	options.SetRange({ {}, series.Time(10) });
+	ret &= Test(TSD(path, options).size() == 10 && TSM(binpath, options).size() == 10, "Load range open begin");
+
+	std::filesystem::remove(binpath);
+	std::filesystem::remove(gorillapath);
+	return ret;
+}
+
+bool TimeSeriesTests::IndexTest()
+{
+	bool ret{ true };
+	const auto path{ std::filesystem::temp_directory_path() / "timeseries_index.csv" };
+	TSD series;
+	for (size_t i = 0; i < 5000; i++)
+	{
+		series.emplace_back(0.01 * i, std::sin(0.01 * i));
+		// multivalue points
+		if (i % 97 == 0)
+			series.emplace_back(0.01 * i, std::cos(0.01 * i));
+	}
+	series.WriteCSV(path);
+	const TSD loaded(path);
+
+	const auto index{ timeseries::CSVIndexT<double, double>::Create(path, 64) };
+	const auto sidecar{ timeseries::CSVIndexT<double, double>::Load(path) };
+	ret &= Test(sidecar.has_value() && sidecar->Entries().size() == index.Entries().size() &&
+		sidecar->Entries().back().Offset == index.Entries().back().Offset, "Index load");
+
+	const auto bounds{ index.ValueBounds(10.0, 20.0) };
+	bool inbounds{ bounds.has_value() };
+	for (size_t i = 0; inbounds && i < loaded.size(); i++)
+		if (loaded.Time(i) >= 10.0 && loaded.Time(i) <= 20.0)
+			inbounds = loaded.Value(i) >= bounds->first && loaded.Value(i) <= bounds->second;
+	ret &= Test(inbounds, "Index value bounds");
+
+	TSD::LoadOptions loadoptions;
+	loadoptions.SetRange({ 12.345, 23.456 });
+	const TSD range(path, loadoptions);
+	bool same{ range.size() > 0 };
+	for (size_t i = 0, j = 0; same && i < loaded.size(); i++)
+		if (loaded.Time(i) >= 12.345 && loaded.Time(i) < 23.456)
+			same = j < range.size() && range.Time(j) == loaded.Time(i) && range.Value(j++) == loaded.Value(i);
+	ret &= Test(same, "Index range load");
+
+	for (const auto process : { timeseries::MultiValuePointProcess::All, timeseries::MultiValuePointProcess::Avg })
+	{
+		TSO options;
+		options.SetTimeTolerance(0.003);
+		options.SetMultiValuePoint(process);
+		bool points{ true };
+		for (double t = -0.5; points && t < 50.5; t += 0.1234)
+		{
+			const auto expected{ loaded.GetTimePoints(t, options) }, indexed{ TSD::GetTimePoints(path, index, t, options) };
+			points = expected.size() == indexed.size();
+			for (size_t i = 0; points && i < expected.size(); i++)
+				points = expected.Time(i) == indexed.Time(i) && expected.Value(i) == indexed.Value(i);
+		}
+		// multivalue points and the ends of the series
+		for (const double t : { 0.0, 0.97, 49.99 })
+			points &= loaded.GetTimePoints(t, options).size() == TSD::GetTimePoints(path, index, t, options).size();
+		ret &= Test(points, "Index time points");
+	}
+
+	// the index of the changed file is stale
+	series.emplace_back(100.0, 0.0);
+	series.WriteCSV(path);
+	ret &= Test(!timeseries::CSVIndexT<double, double>::Load(path).has_value() && TSD(path, loadoptions).size() == range.size(), "Index stale");
+
+	std::filesystem::remove(timeseries::CSVIndexT<double, double>::SidecarPath(path));
+	std::filesystem::remove(path);
+	return ret;
+}
+
+bool TimeSeriesTests::LoadCompressTest()
+{
+	bool ret{ true };
+	const auto path{ TimeSeriesTests::TestPath("tests/compare1.csv") };
+	const auto binpath{ std::filesystem::temp_directory_path() / "timeseries_loadcompress.tsb" };
+	const auto gorillapath{ std::filesystem::temp_directory_path() / "timeseries_loadcompress.tsg" };
+	const TSD series(path);
+	series.WriteBinary(binpath);
+	series.WriteGorilla(gorillapath);
+
+	for (const auto method : { timeseries::CompressMethod::Neighbour, timeseries::CompressMethod::SwingingDoor })
+		for (const bool range : { false, true })
+		{
+			TSO options;
+			options.SetCompression(method);
+			options.SetValueTolerance(1e-3);
+			TSD::LoadOptions loadoptions;
+			if (range)
+				loadoptions.SetRange({ series.Time(series.size() / 4), series.Time(3 * series.size() / 4) });
+			TSD expected(path, loadoptions);
+			expected.Compress(options);
+
+			loadoptions.SetCompress(options);
+			const auto Same = [&expected](const auto& loaded) { return SameSeries(loaded, expected); };
+			ret &= Test(expected.size() > 0 && Same(TSD(path, loadoptions)) && Same(TSD(binpath, loadoptions)) &&
+				Same(TSC(gorillapath, loadoptions)), fmt::format("Load compressed {} points", expected.size()));
+		}
+
+	TSD::LoadOptions loadoptions;
+	loadoptions.SetCompress(TSO());
+	bool thrown{ false };
+	try
+	{
+		TSM mapped(binpath, loadoptions);
+	}
+	catch (const timeseries::Exception&)
+	{
+		thrown = true;
+	}
+	ret &= Test(thrown, "Load compressed mapped");
+
+	std::filesystem::remove(binpath);
+	std::filesystem::remove(gorillapath);
+	return ret;
+}
+
 bool TimeSeriesTests::TestAll()
 {
 	bool ret{ true };
@@ -172,7 +1411,31 @@ bool TimeSeriesTests::TestAll()
 	ret &= Test(CompareTest, "Compare");
 	ret &= Test(DifferenceTest, "Difference");
 	ret &= Test(CompressTest, "Compress");
+	ret &= Test(SwingingDoorTest, "SwingingDoor");
+	ret &= Test(ParallelCompressTest, "ParallelCompress");
 	ret &= Test(OverallTest, "Overall");
+	ret &= Test(CSVTest, "CSV");
+	ret &= Test(ColumnsTest, "Columns");
+	ret &= Test(MergeCompareTest, "MergeCompare");
+	ret &= Test(ParallelCompareTest, "ParallelCompare");
+	ret &= Test(TimePointsTest, "TimePoints");
+	ret &= Test(GallopTest, "Gallop");
+	ret &= Test(EvaluateTest, "Evaluate");
+	ret &= Test(InterpolationTest, "Interpolation");
+	ret &= Test(CompareKernelTest, "Compare kernel");
+	ret &= Test(UniformTest, "Uniform");
+	ret &= Test(MultiChannelTest, "MultiChannel");
+	ret &= Test(MultiColumnTest, "MultiColumn");
+	ret &= Test(ParallelCSVTest, "ParallelCSV");
+	ret &= Test(BinaryTest, "Binary");
+	ret &= Test(GorillaTest, "Gorilla");
+	ret &= Test(CSVWriterTest, "CSVWriter");
+	ret &= Test(DenseRangeTest, "DenseRange");
+	ret &= Test(CompareFilesTest, "CompareFiles");
+	ret &= Test(ViewTest, "View");
+	ret &= Test(LoadRangeTest, "LoadRange");
+	ret &= Test(IndexTest, "Index");
+	ret &= Test(LoadCompressTest, "LoadCompress");
 	return ret;
 }
 
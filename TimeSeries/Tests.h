@@ -1,5 +1,8 @@
 #pragma once
 #include "TimeSeries.h"
+#include "MultiChannel.h"
+#include "SeriesFile.h"
+#include <cstring>
 #include <filesystem>
 
 #ifndef TIMESERIES_TEST_PATH
@@ -19,7 +22,48 @@ namespace timeseries_test
 		static bool CompareTest();
 		static bool DifferenceTest();
 		static bool CompressTest();
+		static bool SwingingDoorTest();
+		static bool ParallelCompressTest();
 		static bool OverallTest();
+		static bool CSVTest();
+		static bool ColumnsTest();
+		static bool MergeCompareTest();
+		static bool ParallelCompareTest();
+		static bool TimePointsTest();
+		static bool GallopTest();
+		static bool EvaluateTest();
+		static bool InterpolationTest();
+		static bool CompareKernelTest();
+		static bool UniformTest();
+		static bool MultiChannelTest();
+		static bool MultiColumnTest();
+		static bool ParallelCSVTest();
+		static bool BinaryTest();
+		static bool GorillaTest();
+		static bool CSVWriterTest();
+		static bool DenseRangeTest();
+		static bool CompareFilesTest();
+		static bool ViewTest();
+		static bool LoadRangeTest();
+		static bool IndexTest();
+		static bool LoadCompressTest();
+		// results are equal to the bit
+		static bool SameResult(const timeseries::CompareResultT<double, double>& lhs, const timeseries::CompareResultT<double, double>& rhs);
+		// series have the same points to the bit
+		template<typename Series1, typename Series2>
+		static bool SameSeries(const Series1& lhs, const Series2& rhs)
+		{
+			if (lhs.size() != rhs.size())
+				return false;
+			for (size_t i = 0; i < lhs.size(); i++)
+			{
+				const auto t1{ lhs.Time(i) }, t2{ rhs.Time(i) };
+				const auto v1{ lhs.Value(i) }, v2{ rhs.Value(i) };
+				if (std::memcmp(&t1, &t2, sizeof(t1)) != 0 || std::memcmp(&v1, &v2, sizeof(v1)) != 0)
+					return false;
+			}
+			return true;
+		}
 		static bool Test(bool (*fnTest)(), const std::string_view TestName);
 		static bool Test(bool result, const std::string_view TestName);
 		static std::filesystem::path TestPath(const std::filesystem::path& path);
@@ -0,0 +1,146 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace timeseries
+{
+	// fixed size pool of worker threads
+	class ThreadPool
+	{
+	protected:
+		std::vector<std::thread> threads_;
+		std::queue<std::function<void()>> tasks_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		bool stop_ = false;
+
+		void Worker()
+		{
+			for (;;)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+					if (stop_ && tasks_.empty())
+						return;
+					task = std::move(tasks_.front());
+					tasks_.pop();
+				}
+				task();
+			}
+		}
+
+	public:
+		explicit ThreadPool(size_t Threads = 0)
+		{
+			if (Threads == 0)
+				Threads = HardwareThreads();
+			for (size_t thread = 0; thread < Threads; thread++)
+				threads_.emplace_back(&ThreadPool::Worker, this);
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for (auto& thread : threads_)
+				thread.join();
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		static size_t HardwareThreads()
+		{
+			return (std::max)(std::thread::hardware_concurrency(), 1u);
+		}
+
+		// pool shared by the library, sized to the machine
+		static ThreadPool& Default()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+		inline size_t size() const { return threads_.size(); }
+
+		void Submit(std::function<void()> Task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.emplace(std::move(Task));
+			}
+			wake_.notify_one();
+		}
+
+		// runs Body(index) for index in [0, Count) and waits for completion. The calling
+		// thread takes part in the work, so nested calls from the pool tasks do not deadlock.
+		// The first exception thrown by Body is rethrown
+		template<typename Fn>
+		void ParallelFor(size_t Count, Fn&& Body)
+		{
+			if (Count == 0)
+				return;
+
+			struct State
+			{
+				std::atomic<size_t> next{ 0 };
+				std::atomic<size_t> done{ 0 };
+				std::atomic<bool> failed{ false };
+				std::exception_ptr error;
+				std::mutex mutex;
+				std::condition_variable finished;
+			};
+
+			// helpers started after all the work is taken only touch the state
+			auto state{ std::make_shared<State>() };
+			const auto Work = [state, &Body, Count]()
+			{
+				for (size_t index; (index = state->next.fetch_add(1)) < Count;)
+				{
+					if (!state->failed)
+					{
+						try
+						{
+							Body(index);
+						}
+						catch (...)
+						{
+							std::lock_guard<std::mutex> lock(state->mutex);
+							if (!state->failed.exchange(true))
+								state->error = std::current_exception();
+						}
+					}
+					if (state->done.fetch_add(1) + 1 == Count)
+					{
+						std::lock_guard<std::mutex> lock(state->mutex);
+						state->finished.notify_all();
+					}
+				}
+			};
+
+			const auto helpers{ (std::min)(Count, size() + 1) - 1 };
+			for (size_t helper = 0; helper < helpers; helper++)
+				Submit(Work);
+
+			Work();
+
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->finished.wait(lock, [&state, Count] { return state->done == Count; });
+			if (state->error)
+				std::rethrow_exception(state->error);
+		}
+	};
+}
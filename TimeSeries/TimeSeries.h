@@ -1,4 +1,7 @@
 #pragma once
+#include <array>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 #include <variant>
 #include <optional>
@@ -9,8 +12,16 @@
 #include <fstream>
 #include <limits>
 #include <locale>
+#include <utility>
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "Exception.h"
+#include "CSV.h"
+#include "Binary.h"
+#include "Gorilla.h"
+#include "CSVIndex.h"
+#include "Interpolation.h"
+#include "CompareKernel.h"
 
 // test namespace forward declaration
 // for test functions friending
@@ -21,13 +32,6 @@ namespace timeseries_test
 
 namespace timeseries
 {
-	class Exception : public std::runtime_error
-	{
-	public:
-		template <typename... Args>
-		Exception(std::string_view Format, Args&&... args) : std::runtime_error(fmt::format(Format, args...)) {}
-	};
-	
 	template<typename T, typename V>
 	class PointT
 	{
@@ -43,44 +47,411 @@ namespace timeseries
 		void v(const V& v) { v_ = v; }
 	};
 
+	// point (array of structures) storage
+	template<typename T, typename V>
+	struct TimeSeriesDataT : public std::vector<PointT<T, V>>
+	{
+		inline const T& Time(size_t Index) const { return (*this)[Index].t(); }
+		inline const V& Value(size_t Index) const { return (*this)[Index].v(); }
+		void Set(size_t Index, const T& Time, const V& Value) { (*this)[Index] = { Time, Value }; }
+
+		// index of the first point from First with time not less than Time
+		size_t LowerBound(size_t First, const T& Time) const
+		{
+			return std::lower_bound(this->begin() + First, this->end(), Time, [](const PointT<T, V>& lhs, const T& rhs)
+				{
+					return lhs.t() < rhs;
+				}) - this->begin();
+		}
+
+		// index of the first point from First with time greater than Time
+		size_t UpperBound(size_t First, const T& Time) const
+		{
+			return std::upper_bound(this->begin() + First, this->end(), Time, [](const T& lhs, const PointT<T, V>& rhs)
+				{
+					return lhs < rhs.t();
+				}) - this->begin();
+		}
+	};
+
+	// random access iterator for storages which return points
+	// by value from operator[]
+	template<typename StorageT, typename T, typename V>
+	class StorageIteratorT
+	{
+	protected:
+		const StorageT* storage_ = nullptr;
+		std::ptrdiff_t index_ = 0;
+
+		// operator-> has to return something with operator->
+		struct PointProxy
+		{
+			PointT<T, V> point;
+			const PointT<T, V>* operator->() const { return &point; }
+		};
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = PointT<T, V>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = PointProxy;
+		using reference = PointT<T, V>;
+
+		StorageIteratorT() = default;
+		StorageIteratorT(const StorageT* storage, std::ptrdiff_t index) : storage_{ storage }, index_{ index } {}
+
+		reference operator*() const { return (*storage_)[index_]; }
+		pointer operator->() const { return { **this }; }
+		reference operator[](difference_type n) const { return (*storage_)[index_ + n]; }
+
+		StorageIteratorT& operator++() { ++index_; return *this; }
+		StorageIteratorT& operator--() { --index_; return *this; }
+		StorageIteratorT operator++(int) { auto it{ *this }; ++index_; return it; }
+		StorageIteratorT operator--(int) { auto it{ *this }; --index_; return it; }
+		StorageIteratorT& operator+=(difference_type n) { index_ += n; return *this; }
+		StorageIteratorT& operator-=(difference_type n) { index_ -= n; return *this; }
+		StorageIteratorT operator+(difference_type n) const { return { storage_, index_ + n }; }
+		StorageIteratorT operator-(difference_type n) const { return { storage_, index_ - n }; }
+		friend StorageIteratorT operator+(difference_type n, const StorageIteratorT& it) { return it + n; }
+		difference_type operator-(const StorageIteratorT& rhs) const { return index_ - rhs.index_; }
+
+		bool operator==(const StorageIteratorT& rhs) const { return index_ == rhs.index_; }
+		bool operator!=(const StorageIteratorT& rhs) const { return index_ != rhs.index_; }
+		bool operator<(const StorageIteratorT& rhs) const { return index_ < rhs.index_; }
+		bool operator>(const StorageIteratorT& rhs) const { return index_ > rhs.index_; }
+		bool operator<=(const StorageIteratorT& rhs) const { return index_ <= rhs.index_; }
+		bool operator>=(const StorageIteratorT& rhs) const { return index_ >= rhs.index_; }
+	};
+
+	// column (structure of arrays) storage. Times and values are kept in
+	// separate contiguous arrays, so time searches do not touch values and
+	// value passes can be vectorized. Points are accessed by value
 	template<typename T, typename V>
-	struct TimeSeriesDataT : public std::vector<PointT<T, V>> {};
+	class TimeSeriesColumnsT
+	{
+	protected:
+		std::vector<T> times_;
+		std::vector<V> values_;
+	public:
+		using value_type = PointT<T, V>;
+
+		using const_iterator = StorageIteratorT<TimeSeriesColumnsT, T, V>;
+		using iterator = const_iterator;
+
+		inline size_t size() const { return times_.size(); }
+		inline bool empty() const { return times_.empty(); }
+		const_iterator begin() const { return { this, 0 }; }
+		const_iterator end() const { return { this, static_cast<std::ptrdiff_t>(size()) }; }
+		PointT<T, V> operator[](size_t Index) const { return { times_[Index], values_[Index] }; }
+		PointT<T, V> front() const { return (*this)[0]; }
+		PointT<T, V> back() const { return (*this)[size() - 1]; }
+
+		void emplace_back(const T& Time, const V& Value)
+		{
+			times_.emplace_back(Time);
+			values_.emplace_back(Value);
+		}
+
+		void emplace_back(const PointT<T, V>& Point) { emplace_back(Point.t(), Point.v()); }
 
+		void reserve(size_t Size)
+		{
+			times_.reserve(Size);
+			values_.reserve(Size);
+		}
+
+		void clear()
+		{
+			times_.clear();
+			values_.clear();
+		}
+
+		void swap(TimeSeriesColumnsT& Columns)
+		{
+			times_.swap(Columns.times_);
+			values_.swap(Columns.values_);
+		}
+
+		void resize(size_t Size)
+		{
+			times_.resize(Size);
+			values_.resize(Size);
+		}
+
+		void Set(size_t Index, const T& Time, const V& Value)
+		{
+			times_[Index] = Time;
+			values_[Index] = Value;
+		}
+
+		inline const T& Time(size_t Index) const { return times_[Index]; }
+		inline const V& Value(size_t Index) const { return values_[Index]; }
+		// contiguous columns for vectorized processing
+		inline const T* Times() const { return times_.data(); }
+		inline const V* Values() const { return values_.data(); }
+
+		size_t LowerBound(size_t First, const T& Time) const
+		{
+			return std::lower_bound(times_.begin() + First, times_.end(), Time) - times_.begin();
+		}
+
+		size_t UpperBound(size_t First, const T& Time) const
+		{
+			return std::upper_bound(times_.begin() + First, times_.end(), Time) - times_.begin();
+		}
+	};
+
+	// uniform grid storage. Only values are stored, time of the point is
+	// Start + Index * Step, so point lookup is computed instead of searched
 	template<typename T, typename V>
-	class Interpolator
+	class TimeSeriesUniformT
 	{
-		using DataT = typename timeseries::TimeSeriesDataT<T, V>;
+	protected:
+		T Start_ = {};
+		T Step_ = {};
+		std::vector<V> values_;
+
+		// clamps index to [First, size()] and corrects it for the rounding,
+		// so that the index is the first with Time(Index) Compare Time
+		template<typename Pred>
+		size_t Bound(size_t First, const T& Time, Pred Before) const
+		{
+			const auto size{ values_.size() };
+			size_t Index{ First };
+			if (Step_ > 0)
+			{
+				const T position{ std::ceil((Time - Start_) / Step_) };
+				if (position >= static_cast<T>(size))
+					Index = size;
+				else if (position > static_cast<T>(First))
+					Index = static_cast<size_t>(position);
+			}
+			while (Index > First && !Before(TimeSeriesUniformT::Time(Index - 1), Time))
+				Index--;
+			while (Index < size && Before(TimeSeriesUniformT::Time(Index), Time))
+				Index++;
+			return Index;
+		}
 	public:
-		V Get(const DataT& Data, typename DataT::const_iterator& Place, const T& Time) const
+		// relative to step deviation of the time from the grid
+		// accepted when the points are added
+		static constexpr double GridTolerance = 1E-6;
+
+		using value_type = PointT<T, V>;
+		using const_iterator = StorageIteratorT<TimeSeriesUniformT, T, V>;
+		using iterator = const_iterator;
+
+		TimeSeriesUniformT() = default;
+		TimeSeriesUniformT(const T& Start, const T& Step) : Start_{ Start }, Step_{ Step } 
+		{
+			if (!(Step > 0))
+				throw Exception("TimeSeriesUniformT - step must be positive: {}", Step);
+		}
+		TimeSeriesUniformT(const T& Start, const T& Step, std::vector<V> Values) : TimeSeriesUniformT(Start, Step)
 		{
-			const auto Interpolate = [](const T& Tl, const V& Vl, const T& Tr, const V& Vr, const T& Time) -> V
+			values_ = std::move(Values);
+		}
+
+		inline const T& Start() const { return Start_; }
+		inline const T& Step() const { return Step_; }
+
+		inline size_t size() const { return values_.size(); }
+		inline bool empty() const { return values_.empty(); }
+		const_iterator begin() const { return { this, 0 }; }
+		const_iterator end() const { return { this, static_cast<std::ptrdiff_t>(size()) }; }
+		PointT<T, V> operator[](size_t Index) const { return { Time(Index), values_[Index] }; }
+		PointT<T, V> front() const { return (*this)[0]; }
+		PointT<T, V> back() const { return (*this)[size() - 1]; }
+
+		// points must follow the grid. If the step is not set it
+		// is taken from the first two points
+		void emplace_back(const T& Time, const V& Value)
+		{
+			if (values_.empty())
+			{
+				if (!(Step_ > 0))
+					Start_ = Time;
+			}
+			else if (!(Step_ > 0))
 			{
-				const auto div{ Tr - Tl };
-				// if denominator is zero - choose points left
-				// or right to Time given
-				if (std::abs(div) > 0)
-					return (Vr - Vl) / (Tr - Tl) * (Time - Tl) + Vl;
+				if (values_.size() == 1 && Time > Start_)
+					Step_ = Time - Start_;
 				else
-					return Tl > Time ? Vl : Vr;
-			};
+					throw Exception("TimeSeriesUniformT::emplace_back - failed to set step from t={} to t={}", Start_, Time);
+			}
+
+			const T expected{ TimeSeriesUniformT::Time(values_.size()) };
+			if (std::abs(Time - expected) > Step_ * GridTolerance)
+				throw Exception("TimeSeriesUniformT::emplace_back - t={} does not match the grid time {}", Time, expected);
+
+			values_.emplace_back(Value);
+		}
+
+		void emplace_back(const PointT<T, V>& Point) { emplace_back(Point.t(), Point.v()); }
+
+		void reserve(size_t Size) { values_.reserve(Size); }
+
+		void clear() { values_.clear(); }
+
+		void swap(TimeSeriesUniformT& Uniform)
+		{
+			std::swap(Start_, Uniform.Start_);
+			std::swap(Step_, Uniform.Step_);
+			values_.swap(Uniform.values_);
+		}
 
-			if (Place != Data.begin())
-				Place--;
+		inline T Time(size_t Index) const { return Start_ + static_cast<T>(Index) * Step_; }
+		inline const V& Value(size_t Index) const { return values_[Index]; }
+		inline const V* Values() const { return values_.data(); }
+
+		size_t LowerBound(size_t First, const T& Time) const
+		{
+			return Bound(First, Time, [](const T& lhs, const T& rhs) { return lhs < rhs; });
+		}
 
-			auto NextPlace{ std::next(Place) };
+		size_t UpperBound(size_t First, const T& Time) const
+		{
+			return Bound(First, Time, [](const T& lhs, const T& rhs) { return !(rhs < lhs); });
+		}
+	};
 
-			if (NextPlace != Data.end())	// got next point ? use current and next to interpolate
-				return (Interpolate)(Place->t(), Place->v(), NextPlace->t(), NextPlace->v(), Time);
-			else if (Place != Data.begin()) // no next point, use previous and current to interpolate
+	// non-owning read-only storage over the columns owned by the application.
+	// Columns may be strided, for example times and values fields of the
+	// array of structures, strides are in bytes. The order of times is
+	// checked once, so the application must keep it while the view is used
+	template<typename T, typename V>
+	class TimeSeriesViewT
+	{
+	protected:
+		const char* times_ = nullptr;
+		const char* values_ = nullptr;
+		std::ptrdiff_t TimeStride_ = sizeof(T);
+		std::ptrdiff_t ValueStride_ = sizeof(V);
+		size_t size_ = 0;
+
+		// first index from First for which Before is false
+		template<typename Pred>
+		size_t Bound(size_t First, Pred Before) const
+		{
+			size_t count{ size_ - First };
+			while (count > 0)
+			{
+				const size_t half{ count / 2 };
+				if (Before(TimeSeriesViewT::Time(First + half)))
 				{
-					auto PrevPlace{ std::prev(Place) };
-					return (Interpolate)(PrevPlace->t(), PrevPlace->v(), Place->t(), Place->v(), Time);
+					First += half + 1;
+					count -= half + 1;
 				}
+				else
+					count = half;
+			}
+			return First;
+		}
+	public:
+		using value_type = PointT<T, V>;
+		using const_iterator = StorageIteratorT<TimeSeriesViewT, T, V>;
+		using iterator = const_iterator;
+
+		TimeSeriesViewT() = default;
+		TimeSeriesViewT(size_t Size, const T* Times, const V* Values) :
+			TimeSeriesViewT(Size, Times, sizeof(T), Values, sizeof(V)) {}
+		TimeSeriesViewT(size_t Size, const T* Times, std::ptrdiff_t TimeStride, const V* Values, std::ptrdiff_t ValueStride) :
+			times_{ reinterpret_cast<const char*>(Times) },
+			values_{ reinterpret_cast<const char*>(Values) },
+			TimeStride_{ TimeStride },
+			ValueStride_{ ValueStride },
+			size_{ Size } {}
+
+		inline size_t size() const { return size_; }
+		inline bool empty() const { return size_ == 0; }
+		const_iterator begin() const { return { this, 0 }; }
+		const_iterator end() const { return { this, static_cast<std::ptrdiff_t>(size()) }; }
+		PointT<T, V> operator[](size_t Index) const { return { Time(Index), Value(Index) }; }
+		PointT<T, V> front() const { return (*this)[0]; }
+		PointT<T, V> back() const { return (*this)[size() - 1]; }
+
+		void swap(TimeSeriesViewT& View)
+		{
+			std::swap(times_, View.times_);
+			std::swap(values_, View.values_);
+			std::swap(TimeStride_, View.TimeStride_);
+			std::swap(ValueStride_, View.ValueStride_);
+			std::swap(size_, View.size_);
+		}
+
+		inline const T& Time(size_t Index) const
+		{
+			return *reinterpret_cast<const T*>(times_ + static_cast<std::ptrdiff_t>(Index) * TimeStride_);
+		}
+
+		inline const V& Value(size_t Index) const
+		{
+			return *reinterpret_cast<const V*>(values_ + static_cast<std::ptrdiff_t>(Index) * ValueStride_);
+		}
+
+		size_t LowerBound(size_t First, const T& Time) const
+		{
+			return Bound(First, [&Time](const T& time) { return time < Time; });
+		}
+
+		size_t UpperBound(size_t First, const T& Time) const
+		{
+			return Bound(First, [&Time](const T& time) { return !(Time < time); });
+		}
+	};
 
-			throw Exception("Interpolator::Get - Failed at t={}", Time);
+	// read-only column storage over the mapped binary series file. The columns
+	// are used in place, so the series is not copied and the pages of the file
+	// are shared by all the processes using it
+	template<typename T, typename V>
+	class TimeSeriesMappedT : public TimeSeriesViewT<T, V>
+	{
+	protected:
+		std::shared_ptr<const MappedFile> file_;
+	public:
+		TimeSeriesMappedT() = default;
+		explicit TimeSeriesMappedT(const BinaryView<T, V>& View) :
+			TimeSeriesViewT<T, V>(View.size(), View.Times(), View.Values()),
+			file_{ View.File() } {}
+
+		// Count points from First taking every Step-th point of the file
+		TimeSeriesMappedT(const BinaryView<T, V>& View, size_t First, size_t Count, size_t Step) :
+			TimeSeriesViewT<T, V>(Count, View.Times() + First, sizeof(T) * Step, View.Values() + First, sizeof(V) * Step),
+			file_{ View.File() } {}
+
+		void swap(TimeSeriesMappedT& Mapped)
+		{
+			TimeSeriesViewT<T, V>::swap(Mapped);
+			std::swap(file_, Mapped.file_);
 		}
 	};
 
+	// storage of the series computed from the series with Storage.
+	// Read-only storages produce the columns
+	template<typename Storage>
+	struct ResultStorage
+	{
+		using type = Storage;
+	};
+
+	template<typename T, typename V>
+	struct ResultStorage<TimeSeriesViewT<T, V>>
+	{
+		using type = TimeSeriesColumnsT<T, V>;
+	};
+
+	template<typename T, typename V>
+	struct ResultStorage<TimeSeriesMappedT<T, V>>
+	{
+		using type = TimeSeriesColumnsT<T, V>;
+	};
+
+	// union times of the operands are off the grid in general
+	template<typename T, typename V>
+	struct ResultStorage<TimeSeriesUniformT<T, V>>
+	{
+		using type = TimeSeriesColumnsT<T, V>;
+	};
+
 	enum class MultiValuePointProcess
 	{
 		All,
@@ -89,6 +460,13 @@ namespace timeseries
 		Avg
 	};
 
+	// method of Compress
+	enum class CompressMethod
+	{
+		Neighbour,		// point is dropped if it is close to the line from the last kept point to the next one
+		SwingingDoor	// error-bounded piecewise-linear compression
+	};
+
 	template <class charT, charT sep>
 	class comma_facet : public std::numpunct<charT>
 	{
@@ -99,60 +477,1033 @@ namespace timeseries
 
 
 	template<typename T, typename V>
-	class TimeSeriesData : protected TimeSeriesDataT<T, V>
+	class TimeSeriesOptionsT
 	{
+	protected:
+		T TimeTolerance_ = 1E-8;
+		V ValueTolerance_ = 1E-8;
+		// comparing function of v1 and v2 : (v2 - v1)/(Rtol * abs(v1) + Atol)
+		V Atol_ = 1.0;		// absolute tolerance
+		V Rtol_ = 0.0;		// relative tolerance
+
+		struct ProcessRange
+		{
+			std::optional<T> begin;
+			std::optional<T> end;
+		};
+
+		ProcessRange Range_;
+
+		MultiValuePointProcess MultiValuePointProcess_ = MultiValuePointProcess::All;
+		CompressMethod CompressMethod_ = CompressMethod::Neighbour;
+
 	public:
-		class OptionsT
+		inline T TimeTolerance() const { return TimeTolerance_; }
+		void SetTimeTolerance(T TimeTolerance) { TimeTolerance_ = TimeTolerance; }
+		inline V ValueTolerance() const { return ValueTolerance_; }
+		void SetValueTolerance(V ValueTolerance) { ValueTolerance_ = ValueTolerance; }
+		inline MultiValuePointProcess MultiValuePoint() const { return MultiValuePointProcess_; }
+		void SetMultiValuePoint(MultiValuePointProcess MultiValuePoint) { MultiValuePointProcess_ = MultiValuePoint; }
+		inline CompressMethod Compression() const { return CompressMethod_; }
+		void SetCompression(CompressMethod Compression) { CompressMethod_ = Compression; }
+		inline const ProcessRange& Range() const { return Range_; }
+		void SetRange(const ProcessRange& Range) { Range_ = Range; }
+		bool TimeInRange(const T& Time) const
 		{
-		protected:
-			T TimeTolerance_ = 1E-8;
-			V ValueTolerance_ = 1E-8;
-			// comparing function of v1 and v2 : (v2 - v1)/(Rtol * abs(v1) + Atol)
-			V Atol_ = 1.0;		// absolute tolerance
-			V Rtol_ = 0.0;		// relative tolerance
+			if (Range_.begin.has_value() && Time < Range_.begin.value())
+				return false;
+			if (Range_.end.has_value() && Time >= Range_.end.value())
+				return false;
+			return true;
+		}
+		V Atol() const { return Atol_; }
+		V Rtol() const { return Rtol_; }
+		void SetAtol(const V& Atol) { Atol_ = Atol; }
+		void SetRtol(const V& Rtol) { Rtol_ = Rtol; }
+	};
+
+	// options of the series loading from files
+	template<typename T, typename V>
+	class LoadOptionsT
+	{
+	protected:
+		size_t Threads_ = 1;
+
+		struct LoadRange
+		{
+			std::optional<T> begin;
+			std::optional<T> end;
+		};
+
+		LoadRange Range_;
+		size_t Decimation_ = 1;
+		std::optional<TimeSeriesOptionsT<T, V>> Compress_;
+	public:
+		// count of threads to parse the file, 0 - all the cores
+		inline size_t Threads() const { return Threads_; }
+		void SetThreads(size_t Threads) { Threads_ = Threads; }
+		// points with times in [begin, end) are loaded only
+		inline const LoadRange& Range() const { return Range_; }
+		void SetRange(const LoadRange& Range) { Range_ = Range; }
+		// every Decimation-th point of the range is loaded
+		inline size_t Decimation() const { return Decimation_; }
+		void SetDecimation(size_t Decimation) { Decimation_ = (std::max)(Decimation, static_cast<size_t>(1)); }
+		// points are compressed while loading as Compress with the options does,
+		// so only the points kept are stored
+		inline const std::optional<TimeSeriesOptionsT<T, V>>& Compress() const { return Compress_; }
+		void SetCompress(const TimeSeriesOptionsT<T, V>& Compress) { Compress_ = Compress; }
+
+		inline bool Filtered() const { return Range_.begin.has_value() || Range_.end.has_value() || Decimation_ > 1; }
+		inline bool BeforeRange(const T& Time) const { return Range_.begin.has_value() && Time < Range_.begin.value(); }
+		inline bool AfterRange(const T& Time) const { return Range_.end.has_value() && Time >= Range_.end.value(); }
+	};
+
+	// streaming compressors of Compress. Push(Index, t, v, Keep) takes the points in order
+	// and calls Keep(Index, t, v) for the points kept, Finish(Keep) decides on the rest.
+	// The decisions after the point kept depend only on that point and the points after
+	// it, as if the compressor started from it, which lets to compress the parts of the
+	// series in parallel and to stitch them. Point decided is the copy, so the kept points
+	// can be written over the points pushed
+
+	// point is dropped if it is close to the last kept point or to the line from
+	// the last kept point to the next one
+	template<typename T, typename V>
+	class NeighbourCompressorT
+	{
+	protected:
+		V tolerance_;
+		T tolt_;
+		PointT<T, V> kept_;			// last kept point
+		PointT<T, V> current_;		// point waiting for the next one
+		size_t index_ = 0;			// index of the current point
+		bool started_ = false;
+		bool pending_ = false;
+
+		template<typename Fn>
+		void Decide(const PointT<T, V>* Next, Fn&& Keep)
+		{
+			const T t{ current_.t() };
+			const V v{ current_.v() };
+			if (std::abs(kept_.t() - t) < tolt_ && std::abs(kept_.v() - v) < tolerance_)
+				return;
 
-			struct ProcessRange
+			if (Next)
 			{
-				std::optional<T> begin;
-				std::optional<T> end;
-			};
+				auto denom{ Next->t() - kept_.t() };
+				if (std::abs(denom) > 0.0)
+				{
+					denom = (Next->v() - kept_.v()) / denom * (t - kept_.t()) + kept_.v();
+					if (std::abs(v - denom) < tolerance_)
+						return;
+				}
+				else
+					return;
+			}
+			kept_ = current_;
+			Keep(index_, t, v);
+		}
+	public:
+		NeighbourCompressorT(const TimeSeriesOptionsT<T, V>& options) :
+			tolerance_{ options.ValueTolerance() },
+			tolt_{ 2.0 * options.TimeTolerance() }
+		{}
+
+		template<typename Fn>
+		void Push(size_t Index, const T& t, const V& v, Fn&& Keep)
+		{
+			const PointT<T, V> point(t, v);
+			if (!started_)
+			{
+				started_ = true;
+				kept_ = point;
+				Keep(Index, t, v);
+				return;
+			}
+			if (pending_)
+				Decide(&point, Keep);
+			current_ = point;
+			index_ = Index;
+			pending_ = true;
+		}
+
+		template<typename Fn>
+		void Finish(Fn&& Keep)
+		{
+			if (pending_)
+				Decide(nullptr, Keep);
+			pending_ = false;
+		}
+	};
+
+	// error-bounded piecewise-linear compressor (swinging door): every dropped point is
+	// within ValueTolerance of the line between the kept points around it. The slopes from
+	// the last kept point allowed by the points after it form the door, the point is kept if
+	// the line to the next point leaves the door. Points closer in time than the doubled time
+	// tolerance are the multivalue point, which is kept whole
+	template<typename T, typename V>
+	class SwingingDoorT
+	{
+	protected:
+		V tolerance_;
+		T tolt_;
+		PointT<T, V> anchor_;		// last kept point
+		PointT<T, V> last_;			// last point pushed, not kept yet
+		size_t index_ = 0;			// index of the last point
+		bool started_ = false;
+		bool pending_ = false;
+		V low_, high_;				// door: slopes allowed by the points from anchor to last
+
+		template<typename Fn>
+		void Anchor(size_t Index, const PointT<T, V>& Point, Fn&& Keep)
+		{
+			anchor_ = Point;
+			low_ = -(std::numeric_limits<V>::max)();
+			high_ = (std::numeric_limits<V>::max)();
+			Keep(Index, Point.t(), Point.v());
+		}
+	public:
+		SwingingDoorT(const TimeSeriesOptionsT<T, V>& options) :
+			tolerance_{ options.ValueTolerance() },
+			tolt_{ 2 * options.TimeTolerance() }
+		{}
+
+		template<typename Fn>
+		void Push(size_t Index, const T& t, const V& v, Fn&& Keep)
+		{
+			const PointT<T, V> point(t, v);
+			if (!started_)
+			{
+				started_ = true;
+				Anchor(Index, point, Keep);
+				return;
+			}
+
+			const auto& previous{ pending_ ? last_ : anchor_ };
+			if (!(t - previous.t() > tolt_))
+			{
+				// multivalue point
+				if (pending_)
+					Anchor(index_, last_, Keep);
+				pending_ = false;
+				Anchor(Index, point, Keep);
+				return;
+			}
+
+			if (pending_)
+			{
+				// the door is narrowed by the last point, which becomes the inner one
+				const T dt{ last_.t() - anchor_.t() };
+				const V low{ (std::max)(low_, (last_.v() - tolerance_ - anchor_.v()) / dt) };
+				const V high{ (std::min)(high_, (last_.v() + tolerance_ - anchor_.v()) / dt) };
+				const V slope{ (v - anchor_.v()) / (t - anchor_.t()) };
+				if (low <= slope && slope <= high)
+				{
+					low_ = low;
+					high_ = high;
+				}
+				else
+					Anchor(index_, last_, Keep);
+			}
+			last_ = point;
+			index_ = Index;
+			pending_ = true;
+		}
+
+		template<typename Fn>
+		void Finish(Fn&& Keep)
+		{
+			if (pending_)
+				Anchor(index_, last_, Keep);
+			pending_ = false;
+		}
+	};
+
+	// aggregates Count values from First to the single value
+	template<typename DataT>
+	double AggregateValues(const DataT& Data, size_t First, size_t Count, MultiValuePointProcess Process)
+	{
+		double MultiValue{ 0 };
+
+		for (size_t TimePoint = First; TimePoint < First + Count; TimePoint++)
+		{
+			switch (Process)
+			{
+			case MultiValuePointProcess::Max:
+				MultiValue = TimePoint == First ? Data.Value(TimePoint) : (std::max)(static_cast<double>(Data.Value(TimePoint)), MultiValue);
+				break;
+			case MultiValuePointProcess::Min:
+				MultiValue = TimePoint == First ? Data.Value(TimePoint) : (std::min)(static_cast<double>(Data.Value(TimePoint)), MultiValue);
+				break;
+			case MultiValuePointProcess::Avg:
+				MultiValue += Data.Value(TimePoint);
+				break;
+			}
+		}
+
+		if (Process == MultiValuePointProcess::Avg)
+			MultiValue /= static_cast<const double>(Count);
+
+		return MultiValue;
+	}
+
+	// points of the series which correspond to the time requested:
+	// Count points from First within time tolerance or, if Count is zero,
+	// interpolation at the segment around First
+	struct TimeSlot
+	{
+		size_t First = 0;
+		size_t Count = 0;
+	};
+
+	// index of the first point from First with time not less than Time. The search
+	// gallops from First with doubling steps and bisects the last step, so it costs
+	// O(log distance) and a walk by small forward moves stays linear
+	template<typename T, typename DataT>
+	size_t GallopLowerBound(const DataT& Data, size_t First, const T& Time)
+	{
+		const size_t size{ Data.size() };
+		if (First >= size || !(Data.Time(First) < Time))
+			return First;
+
+		// time of the point low is less than Time
+		size_t low{ First }, step{ 1 };
+		while (step < size - low && Data.Time(low + step) < Time)
+		{
+			low += step;
+			step *= 2;
+		}
+		size_t high{ step < size - low ? low + step : size };
+		for (low++; low < high;)
+		{
+			const size_t middle{ low + (high - low) / 2 };
+			if (Data.Time(middle) < Time)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+	// index of the first point from First with time not less than Time found by
+	// the point by point walk, which reads the series forward only
+	template<typename T, typename DataT>
+	size_t SequentialLowerBound(const DataT& Data, size_t First, const T& Time)
+	{
+		const size_t size{ Data.size() };
+		while (First < size && Data.Time(First) < Time)
+			First++;
+		return First;
+	}
+
+	// finds time slots for ascending times. Bounds only move forward
+	// by galloping, so the walk through the whole series is linear and
+	// sparse times skip the points between them in logarithmic time.
+	// Sequential cursor walks point by point from First for the series
+	// which can be read forward only, see SeriesWindowT
+	template<typename T, typename DataT>
+	class TimeCursor
+	{
+	protected:
+		const DataT& Data_;
+		size_t Left_ = 0;		// first point with time not less than Time - Tolerance
+		size_t Right_ = 0;		// first point with time not less than Time + Tolerance
+		bool Sequential_ = false;
+
+		size_t LowerBound(size_t First, const T& Time) const
+		{
+			return Sequential_ ? SequentialLowerBound(Data_, First, Time) : GallopLowerBound(Data_, First, Time);
+		}
+	public:
+		TimeCursor(const DataT& Data, size_t First = 0, bool Sequential = false) :
+			Data_{ Data },
+			Left_{ First },
+			Right_{ First },
+			Sequential_{ Sequential } {}
+
+		TimeSlot Seek(const T& Time, const T& Tolerance)
+		{
+			// single point series outputs its point
+			if (Data_.size() == 1)
+				return { 0, 1 };
 
-			ProcessRange Range_;
+			Left_ = LowerBound(Left_, Time - Tolerance);
+			Right_ = LowerBound((std::max)(Left_, Right_), Time + Tolerance);
+			return { Left_, Right_ - Left_ };
+		}
+	};
 
-			MultiValuePointProcess MultiValuePointProcess_ = MultiValuePointProcess::All;
+	// points resolved from the time slot: raw points of the slot or
+	// single point computed by interpolation or aggregation
+	template<typename T, typename V>
+	class SlotPointsT
+	{
+	protected:
+		TimeSlot Slot_;
+		bool Computed_ = false;
+		PointT<T, V> Point_;
+	public:
+		template<typename DataT, typename Interpolation = LinearInterpolationT<T, V>>
+		SlotPointsT(const DataT& Data, const TimeSlot& Slot, const T& Time, const TimeSeriesOptionsT<T, V>& options,
+					const Interpolation& interpolation = Interpolation()) : Slot_{ Slot }
+		{
+			if (Slot.Count == 0)
+			{
+				Computed_ = true;
+				Point_ = { Time, interpolation.Get(Data, Slot.First, Time) };
+			}
+			else if (Slot.Count > 1 && options.MultiValuePoint() != MultiValuePointProcess::All)
+			{
+				Computed_ = true;
+				Point_ = { Time, static_cast<V>(AggregateValues(Data, Slot.First, Slot.Count, options.MultiValuePoint())) };
+			}
+		}
 
+		inline size_t size() const { return Computed_ ? 1 : Slot_.Count; }
+
+		template<typename DataT>
+		inline T t(const DataT& Data, size_t Index) const { return Computed_ ? Point_.t() : Data.Time(Slot_.First + Index); }
+
+		template<typename DataT>
+		inline V v(const DataT& Data, size_t Index) const { return Computed_ ? Point_.v() : Data.Value(Slot_.First + Index); }
+	};
+
+	// evaluation of the series at the ascending times, one value per time, made by
+	// blocks of times. The block sweep depends on the times only, so it is applied to the
+	// values of any channel with the same time axis. Multivalue points are aggregated
+	// as the options say, MultiValuePointProcess::All takes the last value of the point
+	template<typename T, typename V>
+	class EvaluationBlockT
+	{
+	public:
+		static constexpr size_t BlockSize = 256;
+	protected:
+		MultiValuePointProcess process_;
+		T tolerance_;
+		size_t matched_ = 0;
+		size_t interpolated_ = 0;
+		// times matched to the points: indices of the times in the block and slots
+		size_t matchindex_[BlockSize];
+		TimeSlot slots_[BlockSize];
+		// times interpolated: indices of the times in the block, the times, left
+		// points of the segments, time steps of the segments and offsets of the times
+		size_t index_[BlockSize];
+		T time_[BlockSize];
+		size_t left_[BlockSize];
+		T step_[BlockSize];
+		T offset_[BlockSize];
+	public:
+		explicit EvaluationBlockT(const TimeSeriesOptionsT<T, V>& options) :
+			process_{ options.MultiValuePoint() },
+			tolerance_{ options.TimeTolerance() } {}
+
+		// sweeps up to BlockSize times from Times, returns count of the times swept
+		template<typename DataT>
+		size_t Sweep(const DataT& Data, TimeCursor<T, DataT>& Cursor, const T* Times, size_t Count)
+		{
+			if (Data.size() == 0)
+				throw Exception("EvaluationBlockT - the series is empty");
+
+			matched_ = interpolated_ = 0;
+			Count = (std::min)(Count, BlockSize);
+			for (size_t index = 0; index < Count; index++)
+			{
+				const T& time{ Times[index] };
+				if (index > 0 && time < Times[index - 1])
+					throw Exception("EvaluationBlockT - times are not ascending : [{}] > [{}]", Times[index - 1], time);
+
+				const auto slot{ Cursor.Seek(time, tolerance_) };
+				if (slot.Count > 0)
+				{
+					matchindex_[matched_] = index;
+					slots_[matched_++] = slot;
+					continue;
+				}
+
+				const size_t left{ LinearInterpolationT<T, V>::Segment(Data.size(), slot.First, time) };
+				index_[interpolated_] = index;
+				time_[interpolated_] = time;
+				left_[interpolated_] = left;
+				step_[interpolated_] = Data.Time(left + 1) - Data.Time(left);
+				offset_[interpolated_++] = time - Data.Time(left);
+			}
+			return Count;
+		}
+
+		// writes the values of Data, which has the time axis swept, for the times of the block
+		template<typename DataT, typename Interpolation = LinearInterpolationT<T, V>>
+		void Apply(const DataT& Data, V* Values, const Interpolation& interpolation = Interpolation()) const
+		{
+			for (size_t match = 0; match < matched_; match++)
+			{
+				const auto& slot{ slots_[match] };
+				V& value{ Values[matchindex_[match]] };
+				if (slot.Count == 1)
+					value = Data.Value(slot.First);
+				else if (process_ == MultiValuePointProcess::All)
+					value = Data.Value(slot.First + slot.Count - 1);
+				else
+					value = static_cast<V>(AggregateValues(Data, slot.First, slot.Count, process_));
+			}
+
+			if constexpr (!std::is_same_v<Interpolation, LinearInterpolationT<T, V>>)
+			{
+				for (size_t point = 0; point < interpolated_; point++)
+					Values[index_[point]] = interpolation.At(Data, left_[point], time_[point]);
+				return;
+			}
+
+			V vl[BlockSize], vr[BlockSize], result[BlockSize];
+			for (size_t point = 0; point < interpolated_; point++)
+			{
+				vl[point] = Data.Value(left_[point]);
+				vr[point] = Data.Value(left_[point] + 1);
+			}
+
+			// branchless form of LinearInterpolationT::At for the vectorizer: zero
+			// step takes the value left or right to the time
+			for (size_t point = 0; point < interpolated_; point++)
+			{
+				const V interpolated{ (vr[point] - vl[point]) / step_[point] * offset_[point] + vl[point] };
+				const V held{ offset_[point] < 0 ? vl[point] : vr[point] };
+				result[point] = std::abs(step_[point]) > 0 ? interpolated : held;
+			}
+
+			for (size_t point = 0; point < interpolated_; point++)
+				Values[index_[point]] = result[point];
+		}
+	};
+
+	// calls Process(time) for the union of times of the points of both series from First1 to Last1
+	// and from First2 to Last2 merged with tolerance and limited to the range from options
+	template<typename T, typename V, typename DataT1, typename DataT2, typename Fn>
+	void ForEachUnionTime(const DataT1& Data1, size_t First1, size_t Last1,
+						  const DataT2& Data2, size_t First2, size_t Last2,
+						  const TimeSeriesOptionsT<T, V>& options, Fn&& Process)
+	{
+		size_t t1{ First1 }, t2{ First2 };
+		const size_t size1{ Last1 }, size2{ Last2 };
+		const T tolerance{ options.TimeTolerance() * 2.0 };
+		bool stored{ false };
+		T last{};
+
+		const auto StoreTime = [&](const T& time) -> void
+		{
+			if (options.TimeInRange(time))
+				if (!stored || std::abs(last - time) > tolerance)
+				{
+					stored = true;
+					last = time;
+					Process(time);
+				}
+		};
+
+		while (1)
+		{
+			if (t1 != size1)
+			{
+				if (t2 != size2)
+				{
+					if (Data1.Time(t1) < Data2.Time(t2))
+					{
+						StoreTime(Data1.Time(t1));
+						t1++;
+					}
+					else
+					{
+						StoreTime(Data2.Time(t2));
+						t2++;
+					}
+				}
+				else
+				{
+					StoreTime(Data1.Time(t1));
+					t1++;
+				}
+			}
+			else if (t2 != size2)
+			{
+				StoreTime(Data2.Time(t2));
+				t2++;
+			}
+			else
+				break;
+
+		}
+	}
+
+	// calls Process(time) for the union of times of both series
+	// merged with tolerance and limited to the range from options
+	template<typename T, typename V, typename DataT1, typename DataT2, typename Fn>
+	void ForEachUnionTime(const DataT1& Data1, const DataT2& Data2, const TimeSeriesOptionsT<T, V>& options, Fn&& Process)
+	{
+		ForEachUnionTime(Data1, 0, Data1.size(), Data2, 0, Data2.size(), options, Process);
+	}
+
+	// resolves slots of two series for the Time and calls Pair(Time, t1, v1, v2)
+	// for the points of the first series paired with the points of the second one
+	template<typename T, typename V, typename DataT1, typename DataT2, typename Interpolation1, typename Interpolation2, typename Fn>
+	void ForEachSlotPair(const DataT1& Data1, const TimeSlot& Slot1, const Interpolation1& interpolation1,
+						 const DataT2& Data2, const TimeSlot& Slot2, const Interpolation2& interpolation2,
+						 const T& Time, const TimeSeriesOptionsT<T, V>& options, Fn&& Pair)
+	{
+		const SlotPointsT<T, V> points1(Data1, Slot1, Time, options, interpolation1);
+		const SlotPointsT<T, V> points2(Data2, Slot2, Time, options, interpolation2);
+		const size_t count{ (std::min)(points1.size(), points2.size()) };
+		for (size_t point = 0; point < count; point++)
+			Pair(Time, points1.t(Data1, point), points1.v(Data1, point), points2.v(Data2, point));
+	}
+
+	// slot pairs of the series interpolated linearly
+	template<typename T, typename V, typename DataT1, typename DataT2, typename Fn>
+	void ForEachSlotPair(const DataT1& Data1, const TimeSlot& Slot1, 
+						 const DataT2& Data2, const TimeSlot& Slot2,
+						 const T& Time, const TimeSeriesOptionsT<T, V>& options, Fn&& Pair)
+	{
+		const LinearInterpolationT<T, V> linear;
+		ForEachSlotPair(Data1, Slot1, linear, Data2, Slot2, linear, Time, options, Pair);
+	}
+
+	// points returned for a time. Usually it is the single point, so a few
+	// points are kept inline and the heap is used only when they overflow
+	template<typename T, typename V, size_t N = 4>
+	class TimePointsT
+	{
+	protected:
+		std::array<PointT<T, V>, N> inline_;
+		std::vector<PointT<T, V>> heap_;
+		size_t size_ = 0;
+	public:
+		using value_type = PointT<T, V>;
+		using const_iterator = const PointT<T, V>*;
+
+		inline size_t size() const { return size_; }
+		inline bool empty() const { return size_ == 0; }
+		inline const PointT<T, V>* data() const { return heap_.empty() ? inline_.data() : heap_.data(); }
+		const_iterator begin() const { return data(); }
+		const_iterator end() const { return data() + size_; }
+		const PointT<T, V>& operator[](size_t Index) const { return data()[Index]; }
+		const PointT<T, V>& front() const { return data()[0]; }
+		const PointT<T, V>& back() const { return data()[size_ - 1]; }
+		inline const T& Time(size_t Index) const { return data()[Index].t(); }
+		inline const V& Value(size_t Index) const { return data()[Index].v(); }
+
+		// heap capacity is kept to be reused
+		void clear()
+		{
+			size_ = 0;
+			heap_.clear();
+		}
+
+		void emplace_back(const T& Time, const V& Value)
+		{
+			if (heap_.empty())
+			{
+				if (size_ < N)
+				{
+					inline_[size_++] = { Time, Value };
+					return;
+				}
+				heap_.reserve(2 * N);
+				heap_.assign(inline_.begin(), inline_.end());
+			}
+			heap_.emplace_back(Time, Value);
+			size_++;
+		}
+	};
+
+	template<typename T, typename V>
+	class CompareResultT
+	{
+	protected:
+		using Options = TimeSeriesOptionsT<T, V>;
+
+		class MinMaxData : public PointT<T, V>
+		{
+		protected:
+			V v1_ = {};
+			V v2_ = {};
 		public:
-			inline T TimeTolerance() const { return TimeTolerance_; }
-			void SetTimeTolerance(T TimeTolerance) { TimeTolerance_ = TimeTolerance; }
-			inline V ValueTolerance() const { return ValueTolerance_; }
-			void SetValueTolerance(V ValueTolerance) { ValueTolerance_ = ValueTolerance; }
-			inline MultiValuePointProcess MultiValuePoint() const { return MultiValuePointProcess_; }
-			void SetMultiValuePoint(MultiValuePointProcess MultiValuePoint) { MultiValuePointProcess_ = MultiValuePoint; }
-			inline const ProcessRange& Range() const { return Range_; }
-			void SetRange(const ProcessRange& Range) { Range_ = Range; }
-			bool TimeInRange(const T& Time) const
-			{
-				if (Range_.begin.has_value() && Time < Range_.begin.value())
-					return false;
-				if (Range_.end.has_value() && Time >= Range_.end.value())
-					return false;
-				return true;
-			}
-			V Atol() const { return Atol_; }
-			V Rtol() const { return Rtol_; }
-			void SetAtol(const V& Atol) { Atol_ = Atol; }
-			void SetRtol(const V& Rtol) { Rtol_ = Rtol; }
+			V v1() const { return v1_; }
+			V v2() const { return v2_; }
+			void v1(V v) { v1_ = v; }
+			void v2(V v) { v2_ = v; }
 		};
+		MinMaxData Max_, Min_;
+		V Sum_ = {};
+		V SqSum_ = {};
+		V Avg_ = {};
+		bool Reset_ = true;
+		bool Finished_ = false;
+		size_t Count_ = 0;
+		V KSDiffSum_ = {};	// Kolmogorov-Smirnov accumulator
+		V KSDiff_ = {};		// Kolmogorov-Smirnov max difference
+		V KSHigh_ = {};		// Kolmogorov-Smirnov accumulator extremes
+		V KSLow_ = {};
+		// tolerances of the pending pairs, the block is folded when they change
+		V Rtol_ = {};
+		V Atol_ = {};
+		// pairs waiting for the block to be filled. The buffers grow with the pairs
+		// and are released by Finish, so the result with no pending pairs is small
+		std::vector<T> times_;
+		std::vector<V> values1_;
+		std::vector<V> values2_;
+		size_t pending_ = 0;
+
+		inline static V AbsWeightedDifference(const V& v1, const V& v2, const Options& options)
+		{
+			return std::abs(CompareResultT::WeightedDifference(v1, v2, options));
+		}
+
+		inline static V WeightedDifference(const V& v1, const V& v2, const Options& options)
+		{
+			return (v1 - v2) / (options.Rtol() * std::abs((std::max)(v1, v2)) + options.Atol());
+		}
+
+		// index of the first value equal to the extremum found, as the sequential
+		// scan with the strict comparison finds it. NaN can be the extremum only
+		// if it is the first value, which the scan keeps
+		static size_t Find(const V* Values, size_t Count, const V& Extremum)
+		{
+			for (size_t index = 0; index < Count; index++)
+				if (Values[index] == Extremum)
+					return index;
+			return 0;
+		}
+
+		// folds the block of aligned pairs to the result. Differences, weighted differences,
+		// squares, extremes and the prefix sums of Kolmogorov-Smirnov are computed by the
+		// vectorized kernel. Block statistics are added in order of the blocks
+		void Fold(const T* Times, const V* Values1, const V* Values2, size_t Count)
+		{
+			if (Count == 0)
+				return;
+
+			V diff[BlockSize], awd[BlockSize];
+			const auto [square, high, low] { CompareKernelT<V>::Run(Values1, Values2, Count, Rtol_, Atol_, diff, awd) };
+			const size_t max{ Find(awd, Count, high) }, min{ Find(awd, Count, low) };
+
+			const auto [prefix, prefixhigh, prefixlow] { CompareKernelT<V>::Prefix(diff, Count) };
+
+			const auto Point = [&](size_t Index)
+			{
+				MinMaxData point;
+				point.t(Times[Index]);
+				point.v(awd[Index]);
+				point.v1(Values1[Index]);
+				point.v2(Values2[Index]);
+				return point;
+			};
+
+			Combine(Point(max), Point(min), prefixhigh, prefixlow, prefix, square, Count);
+		}
+
+		// adds the statistics of the pairs following the pairs of the result: extremes of the
+		// weighted differences, extremes of the running sum relative to the part, sums and count
+		void Combine(const MinMaxData& Max, const MinMaxData& Min, const V& High, const V& Low, const V& Sum, const V& SqSum, size_t Count)
+		{
+			if (Reset_)
+			{
+				Reset_ = false;
+				Max_ = Max;
+				Min_ = Min;
+				KSHigh_ = High;
+				KSLow_ = Low;
+			}
+			else
+			{
+				if (std::abs(Max_.v()) < Max.v())
+					Max_ = Max;
+				if (std::abs(Min_.v()) > Min.v())
+					Min_ = Min;
+				// running sum of the part is shifted by the sum before it
+				KSHigh_ = (std::max)(KSHigh_, KSDiffSum_ + High);
+				KSLow_ = (std::min)(KSLow_, KSDiffSum_ + Low);
+			}
+			KSDiff_ = (std::max)(std::abs(KSHigh_), std::abs(KSLow_));
+
+			KSDiffSum_ += Sum;
+			Sum_ += Sum;
+			SqSum_ += SqSum;
+			Count_ += Count;
+		}
+
+		void FoldPending()
+		{
+			Fold(times_.data(), values1_.data(), values2_.data(), pending_);
+			pending_ = 0;
+			times_.clear();
+			values1_.clear();
+			values2_.clear();
+		}
+
+		// the pending pairs are folded before the block with the other tolerances
+		void Tolerances(const Options& options)
+		{
+			if (pending_ > 0 && (Rtol_ != options.Rtol() || Atol_ != options.Atol()))
+				FoldPending();
+			Rtol_ = options.Rtol();
+			Atol_ = options.Atol();
+		}
+
+		// reads the statistics with the pending pairs folded, the result itself is not
+		// changed, so the accessors are safe for the result shared by the threads
+		template<typename Fn>
+		auto Folded(Fn&& Get) const
+		{
+			if (pending_ == 0)
+				return Get(*this);
+			CompareResultT folded(*this);
+			folded.FoldPending();
+			return Get(folded);
+		}
+	public:
+		// pairs are accumulated by blocks, the accessors fold the pending pairs and
+		// the average is computed by Finish. Block boundaries are at the same pairs
+		// however the pairs are passed, so the result does not depend on the way of
+		// the update. The pairs with other tolerances start the new block
+		static constexpr size_t BlockSize = 1024;
+		static constexpr size_t Lanes = CompareKernelT<V>::Lanes;
+		// points of the longer series in the chunk of the comparison, see CompareChunks
+		static constexpr size_t ChunkSize = 65536;
+
+		CompareResultT()
+		{
+			Reset();
+		}
 
-		using Options = typename TimeSeriesData::OptionsT;
+		void Reset()
+		{
+			Count_ = {};
+			Finished_ = false;
+			Sum_ = {};
+			KSDiffSum_ = {};
+			KSDiff_ = {};
+			KSHigh_ = {};
+			KSLow_ = {};
+			Avg_ = {};
+			SqSum_ = {};
+			Reset_ = true;
+			pending_ = 0;
+			times_.clear();
+			values1_.clear();
+			values2_.clear();
+		}
+
+		template<typename Series>
+		void Update(const Series& series1, const Series& series2, const Options& options)
+		{
+			for (auto pt1{ series1.begin() }, pt2{ series2.begin() }; pt1 != series1.end() && pt2 != series2.end(); pt1++, pt2++)
+				Update(pt1->t(), pt1->v(), pt2->v(), options);
+		}
+
+		// updates with the single pair of aligned values
+		void Update(const T& t, const V& v1, const V& v2, const Options& options)
+		{
+			Tolerances(options);
+			times_.push_back(t);
+			values1_.push_back(v1);
+			values2_.push_back(v2);
+			if (++pending_ == BlockSize)
+				FoldPending();
+		}
+
+		// updates with Count aligned pairs, the whole blocks are folded in place
+		// with no buffering
+		void Update(const T* Times, const V* Values1, const V* Values2, size_t Count, const Options& options)
+		{
+			Tolerances(options);
+			while (Count > 0)
+			{
+				if (pending_ == 0 && Count >= BlockSize)
+				{
+					Fold(Times, Values1, Values2, BlockSize);
+					Times += BlockSize;
+					Values1 += BlockSize;
+					Values2 += BlockSize;
+					Count -= BlockSize;
+					continue;
+				}
+				Update(*Times++, *Values1++, *Values2++, options);
+				Count--;
+			}
+		}
+
+		// merges the result of the pairs following the pairs of this result, so the results
+		// of the consecutive parts of the comparison merged in order give the whole result.
+		// Merge is deterministic: the same parts merged in the same order give the same bits
+		CompareResultT& Merge(const CompareResultT& Next)
+		{
+			if (Next.pending_ > 0)
+			{
+				CompareResultT next(Next);
+				next.FoldPending();
+				return Merge(next);
+			}
+
+			FoldPending();
+			if (!Next.Reset_)
+			{
+				Combine(Next.Max_, Next.Min_, Next.KSHigh_, Next.KSLow_, Next.Sum_, Next.SqSum_, Next.Count_);
+				Finished_ = false;
+			}
+			return *this;
+		}
+
+		CompareResultT& Finish()
+		{
+			FoldPending();
+			if (times_.capacity() > 0)
+			{
+				// the buffers are not needed by the finished result
+				std::vector<T>().swap(times_);
+				std::vector<V>().swap(values1_);
+				std::vector<V>().swap(values2_);
+			}
+
+			if (!Finished_)
+			{
+				if (Count_ > 0)
+					Avg_ = Sum_ / Count_;
+				Finished_ = true;
+			}
+
+			return *this;
+		}
+
+		bool Idenctical(const T& Tolerance = {}) const
+		{
+			return Max().v() <= Tolerance;
+		}
+
+		const V KSTest() const 
+		{
+			return Folded([](const CompareResultT& result) { return result.KSDiff_; });
+		}
+
+		const MinMaxData Max() const
+		{
+			return Folded([](const CompareResultT& result) { return result.Max_; });
+		}
+
+		const MinMaxData Min() const
+		{
+			return Folded([](const CompareResultT& result) { return result.Min_; });
+		}
+
+		const T Avg() const
+		{
+			return Avg_;
+		}
+
+		const T Sum() const
+		{
+			return Folded([](const CompareResultT& result) { return result.Sum_; });
+		}
+
+		const T SqSum() const
+		{
+			return Folded([](const CompareResultT& result) { return result.SqSum_; });
+		}
+
+
+	};
+
+	// splits both series to the chunks of about CompareResultT::ChunkSize points of the longer
+	// one for the comparison. Chunk starts from the first points of the series with
+	// times not less than the time of the boundary, which is farther than the doubled
+	// time tolerance from the times before it. So the walk of the union times started
+	// afresh at the boundary gives the same times as the walk of the whole series.
+	// Returns the first points of the chunks and the ends of the series
+	template<typename T, typename V, typename DataT1, typename DataT2>
+	std::vector<std::pair<size_t, size_t>> CompareChunks(const DataT1& Data1, const DataT2& Data2, const TimeSeriesOptionsT<T, V>& options)
+	{
+		constexpr size_t chunksize{ CompareResultT<T, V>::ChunkSize };
+		const size_t size1{ Data1.size() }, size2{ Data2.size() };
+		const T tolerance{ options.TimeTolerance() * 2.0 };
+
+		std::vector<std::pair<size_t, size_t>> chunks{ { 0, 0 } };
+		// boundaries are the points of the longer series, the other one is searched
+		const bool longer1{ size1 >= size2 };
+		const size_t size{ longer1 ? size1 : size2 };
+		size_t other{ 0 };
+		for (size_t candidate = chunksize; candidate < size; candidate += chunksize)
+			// boundary is searched for up to the next candidate
+			for (size_t point = candidate; point < (std::min)(candidate + chunksize, size); point++)
+			{
+				const auto Boundary = [&](const auto& Longer, const auto& Other) -> bool
+				{
+					const T time{ Longer.Time(point) };
+					if (!(time - Longer.Time(point - 1) > tolerance))
+						return false;
+					other = GallopLowerBound(Other, other, time);
+					if (other > 0 && !(time - Other.Time(other - 1) > tolerance))
+						return false;
+					chunks.emplace_back(longer1 ? point : other, longer1 ? other : point);
+					return true;
+				};
+				if (longer1 ? Boundary(Data1, Data2) : Boundary(Data2, Data1))
+					break;
+			}
+		chunks.emplace_back(size1, size2);
+		return chunks;
+	}
+
+	template<typename T, typename V, typename Storage = TimeSeriesDataT<T, V>, typename Interpolation = LinearInterpolationT<T, V>>
+	class TimeSeriesData;
+
+	// Interpolation is the policy from Interpolation.h used for the times between the points
+	template<typename T, typename V, typename Storage, typename Interpolation>
+	class TimeSeriesData : protected Storage
+	{
+	public:
+		using OptionsT = TimeSeriesOptionsT<T, V>;
+		using Options = OptionsT;
+		using CompareResult = CompareResultT<T, V>;
+		using LoadOptions = LoadOptionsT<T, V>;
 	protected:
 		friend class timeseries_test::TimeSeriesTests;
-		using fwitT = typename TimeSeriesData<T,V>::const_iterator;
+		template<typename, typename, typename, typename> friend class TimeSeriesData;
+		friend class CompareResultT<T, V>;
+		using fwitT = typename Storage::const_iterator;
 		using pointT = typename timeseries::PointT<T, V>;
-		using NonMonotonicPairT = std::optional<std::pair<const pointT&, const pointT&>>;
+		using NonMonotonicPairT = std::optional<std::pair<pointT, pointT>>;
+		// storage uses binary file in place and can't be filled
+		static constexpr bool MappedStorage = std::is_constructible_v<Storage, const BinaryView<T, V>&>;
+		// points of the storage can be overwritten in place
+		static constexpr bool WritableStorage = std::is_same_v<Storage, TimeSeriesDataT<T, V>> || std::is_same_v<Storage, TimeSeriesColumnsT<T, V>>;
+		// points kept by the compression are off the grid in general
+		static constexpr bool UniformStorage = std::is_same_v<Storage, TimeSeriesUniformT<T, V>>;
 		mutable bool Checked_ = false;
+		// coefficients of the interpolation are computed by Check after the points are
+		// changed. Check is called by the queries and before the threads of the parallel
+		// operations, so the threads only read the coefficients. The series is to be
+		// queried once before it is shared by the threads of the application
+		mutable Interpolation interpolation_;
+
+		// the points are changed: the order is to be checked and the coefficients
+		// of the interpolation to be computed again
+		void Modified()
+		{
+			Checked_ = false;
+			interpolation_.Invalidate();
+		}
+
+		template<typename... Args>
+		void emplace_back(Args&&... args)
+		{
+			Storage::emplace_back(std::forward<Args>(args)...);
+			Modified();
+		}
+
+		void Set(size_t Index, const T& Time, const V& Value)
+		{
+			Storage::Set(Index, Time, Value);
+			Modified();
+		}
+
 		void Check() const
 		{
+			interpolation_.Prepare(static_cast<const Storage&>(*this));
 			if (Checked_)
 				return;
 
@@ -164,104 +1515,297 @@ namespace timeseries
 			Checked_ = true;
 		}
 
-		std::pair<const T, const T> ToleranceRange(const T& Time, const T& HalfTolerance) const
+		std::pair<const T, const T> ToleranceRange(const T& Time, const T& HalfTolerance) const
+		{
+			return { Time - HalfTolerance, Time + HalfTolerance };
+		}
+
+		// calls Process(time) for the union of times of both series
+		// merged with tolerance and limited to the range from options
+		template<typename ExtStorage, typename ExtInterpolation, typename Fn>
+		void ForEachUnionTime(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options, Fn&& Process) const
+		{
+			timeseries::ForEachUnionTime(static_cast<const Storage&>(*this), static_cast<const ExtStorage&>(ExtData), options, Process);
+		}
+
+		template<typename ExtStorage, typename ExtInterpolation>
+		std::vector<T> UnionTime(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options) const
+		{
+			std::vector<T> uniontime;
+			ForEachUnionTime(ExtData, options, [&uniontime](const T& Time)
+				{
+					uniontime.emplace_back(Time);
+				});
+			return uniontime;
+		}
+
+		// single pass merge of both series: walks union times with forward only
+		// cursors and calls Pair(time, t1, v1, v2) for aligned points of the series
+		// with interpolation and aggregation resolved in place
+		template<typename ExtStorage, typename ExtInterpolation, typename Fn>
+		void ForEachAligned(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options, Fn&& Pair) const
+		{
+			Check();
+			ExtData.Check();
+			ForEachAligned(ExtData, options, { 0, 0 }, { TimeSeriesData::size(), ExtData.size() }, Pair);
+		}
+
+		// the merge of the chunk of the union times starting from the points First
+		// of both series up to the points Last, see CompareChunks. The series are
+		// to be checked before, so the chunks can be merged by the threads
+		template<typename ExtStorage, typename ExtInterpolation, typename Fn>
+		void ForEachAligned(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options,
+							const std::pair<size_t, size_t>& First, const std::pair<size_t, size_t>& Last, Fn&& Pair) const
+		{
+			if (TimeSeriesData::empty() || ExtData.empty())
+				return;
+
+			const Storage& data1{ *this };
+			const ExtStorage& data2{ ExtData };
+			TimeCursor<T, Storage> cursor1(data1);
+			TimeCursor<T, ExtStorage> cursor2(data2);
+
+			timeseries::ForEachUnionTime(data1, First.first, Last.first, data2, First.second, Last.second, options, [&](const T& Time)
+				{
+					ForEachSlotPair(data1, cursor1.Seek(Time, options.TimeTolerance()), interpolation_,
+									data2, cursor2.Seek(Time, options.TimeTolerance()), ExtData.interpolation_, Time, options, Pair);
+				});
+		}
+
+		// chunks of the comparison, see timeseries::CompareChunks
+		template<typename ExtStorage, typename ExtInterpolation>
+		std::vector<std::pair<size_t, size_t>> CompareChunks(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options) const
+		{
+			return timeseries::CompareChunks(static_cast<const Storage&>(*this), static_cast<const ExtStorage&>(ExtData), options);
+		}
+
+		// points [first, last) of the binary file which are in the options range
+		static std::pair<size_t, size_t> BinaryRange(const TimeSeriesViewT<T, V>& Columns, const LoadOptions& options)
+		{
+			const auto& range{ options.Range() };
+			const size_t first{ range.begin.has_value() ? Columns.LowerBound(0, range.begin.value()) : 0 };
+			const size_t last{ range.end.has_value() ? Columns.LowerBound(first, range.end.value()) : Columns.size() };
+			return { first, last };
+		}
+
+		// reads points of the options range with decimation from the file of any format
+		// and passes them to Record(time, value). Reserve(count) is called with the count
+		// of the points if it is known before reading. Binary file is searched for the
+		// range, other files are read up to the end of the range only
+		template<typename ReserveFn, typename RecordFn>
+		static void ReadFiltered(const std::filesystem::path& path, const LoadOptions& options, ReserveFn&& Reserve, RecordFn&& Record)
+		{
+			const auto step{ options.Decimation() };
+			size_t counter{ 0 };
+			// decimation counts the points of the range
+			const auto Filter = [&options, &counter, step](const T& time)
+			{
+				if (options.BeforeRange(time))
+					return CSVRecord::Skip;
+				if (options.AfterRange(time))
+					return CSVRecord::Stop;
+				return counter++ % step == 0 ? CSVRecord::Take : CSVRecord::Skip;
+			};
+
+			if (BinaryView<T, V>::Is(path))
+			{
+				const BinaryView<T, V> view(path);
+				const TimeSeriesViewT<T, V> columns(view.size(), view.Times(), view.Values());
+				const auto [first, last] { BinaryRange(columns, options) };
+				Reserve((last - first + step - 1) / step);
+				for (size_t point = first; point < last; point += step)
+					Record(columns.Time(point), columns.Value(point));
+			}
+			else if (GorillaFile::Is(path))
+				GorillaFile::Read<T, V>(path, [](size_t) {}, [&Filter, &Record](const T& time, const V& value)
+					{
+						const auto decision{ Filter(time) };
+						if (decision == CSVRecord::Take)
+							Record(time, value);
+						return decision != CSVRecord::Stop;
+					});
+			else
+			{
+				// sidecar index lets to skip the records before the range
+				uint64_t offset{ 0 };
+				if (options.Range().begin.has_value())
+					if (const auto index{ CSVIndexT<T, V>::Load(path) }; index.has_value())
+						offset = index->Seek(options.Range().begin.value());
+				CSVReader(path).Read<T, V>(Filter, Record, offset);
+			}
+		}
+
+		// loads points of the options range with decimation
+		void LoadFiltered(const std::filesystem::path& path, const LoadOptions& options)
+		{
+			if constexpr (MappedStorage)
+			{
+				const BinaryView<T, V> view(path);
+				const TimeSeriesViewT<T, V> columns(view.size(), view.Times(), view.Values());
+				const auto [first, last] { BinaryRange(columns, options) };
+				const auto step{ options.Decimation() };
+				static_cast<Storage&>(*this) = Storage(view, first, (last - first + step - 1) / step, step);
+			}
+			else
+				ReadFiltered(path, options,
+					[this](size_t count) { TimeSeriesData::reserve(count); },
+					[this](const T& time, const V& value) { TimeSeriesData::emplace_back(time, value); });
+		}
+
+		// feeds the points read straight into the compressor, so the points dropped are never stored
+		template<typename Compressor>
+		void LoadCompressedBy(const std::filesystem::path& path, const LoadOptions& options, Compressor compressor)
 		{
-			return { Time - HalfTolerance, Time + HalfTolerance };
+			size_t index{ 0 };
+			const auto Keep = [this](size_t, const T& t, const V& v)
+			{
+				TimeSeriesData::emplace_back(t, v);
+			};
+			ReadFiltered(path, options, [](size_t) {}, [&compressor, &index, &Keep](const T& time, const V& value)
+				{
+					compressor.Push(index++, time, value, Keep);
+				});
+			compressor.Finish(Keep);
 		}
 
-		std::vector<T> UnionTime(const TimeSeriesData& ExtData, const Options& options) const
+		void LoadCompressed(const std::filesystem::path& path, const LoadOptions& options)
 		{
-			std::vector<T> uniontime;
-
-			auto t1{ TimeSeriesData::begin() };
-			auto t2{ ExtData.begin() };
-			const auto& locoptions{ options };
-
+			if constexpr (UniformStorage)
+				throw Exception("TimeSeriesData::LoadCompressed - uniform grid can't hold the compressed points of {}", path.string());
+			const auto& compress{ options.Compress().value() };
+			if (compress.Compression() == CompressMethod::SwingingDoor)
+				LoadCompressedBy(path, options, SwingingDoorT<T, V>(compress));
+			else
+				LoadCompressedBy(path, options, NeighbourCompressorT<T, V>(compress));
+		}
 
-			const auto StoreTime = [&uniontime, &locoptions](const T& Time) -> void
+		template<typename Compressor>
+		void CompressBy(Compressor compressor, size_t Threads)
+		{
+			const size_t size{ TimeSeriesData::size() };
+			if constexpr (!WritableStorage)
 			{
-				if(locoptions.TimeInRange(Time))
-					if (uniontime.empty() || std::abs(uniontime.back() - Time) > locoptions.TimeTolerance() * 2.0)
-						uniontime.emplace_back(Time);
-			};
-
-			while (1)
+				TimeSeriesData compressed;
+				const auto Keep = [&compressed](size_t, const T& t, const V& v)
+				{
+					compressed.emplace_back(t, v);
+				};
+				for (size_t point = 0; point < size; point++)
+					compressor.Push(point, TimeSeriesData::Time(point), TimeSeriesData::Value(point), Keep);
+				compressor.Finish(Keep);
+				TimeSeriesData::swap(compressed);
+			}
+			else
 			{
-				if (t1 != TimeSeriesData::end())
+				if (Threads == 0)
+					Threads = ThreadPool::HardwareThreads();
+
+				if (Threads < 2 || size < 2 * Threads)
 				{
-					if (t2 != ExtData.end())
+					// kept point is never ahead of the point pushed
+					size_t kept{ 0 };
+					const auto Keep = [this, &kept](size_t, const T& t, const V& v)
+					{
+						Storage::Set(kept++, t, v);
+					};
+					for (size_t point = 0; point < size; point++)
+						compressor.Push(point, TimeSeriesData::Time(point), TimeSeriesData::Value(point), Keep);
+					compressor.Finish(Keep);
+					Storage::resize(kept);
+					return;
+				}
+
+				// the parts are compressed independently up to the first point of the next part,
+				// the compressors keep the states at the ends of the parts
+				const size_t parts{ Threads };
+				std::vector<std::vector<bool>> flags(parts);
+				std::vector<std::vector<size_t>> overflows(parts);		// points of the next part kept
+				std::vector<Compressor> compressors(parts, compressor);
+				const auto First = [size, parts](size_t part) { return size * part / parts; };
+				ThreadPool::Default().ParallelFor(parts, [&](size_t part)
 					{
-						if (t1->t() < t2->t())
+						const size_t first{ First(part) }, last{ First(part + 1) };
+						auto& kept{ flags[part] };
+						kept.assign(last - first, false);
+						const auto Keep = [&kept, &overflows, first, last, part](size_t index, const T&, const V&)
 						{
-							StoreTime(t1->t());
-							t1++;
-						}
+							if (index < last)
+								kept[index - first] = true;
+							else
+								overflows[part].push_back(index);
+						};
+						for (size_t point = first; point < last; point++)
+							compressors[part].Push(point, TimeSeriesData::Time(point), TimeSeriesData::Value(point), Keep);
+						if (last < size)
+							compressors[part].Push(last, TimeSeriesData::Time(last), TimeSeriesData::Value(last), Keep);
 						else
+							compressors[part].Finish(Keep);
+					});
+
+				// the sequential compression is continued from the end of the previous part
+				// until it keeps the point kept by the part, the decisions after it are the same
+				for (size_t part = 1; part < parts; part++)
+				{
+					const size_t first{ First(part) }, last{ First(part + 1) };
+					Compressor sequential{ compressors[part - 1] };
+					std::vector<bool> kept(last - first, false);
+					std::vector<size_t> overflow;
+					size_t latest{ size };		// last point kept by the push
+					const auto Keep = [&kept, &overflow, &latest, first, last](size_t index, const T&, const V&)
+					{
+						if (index < last)
 						{
-							StoreTime(t2->t());
-							t2++;
+							kept[index - first] = true;
+							latest = index;
 						}
+						else
+							overflow.push_back(index);
+					};
+					for (const auto index : overflows[part - 1])
+						Keep(index, {}, {});
+
+					bool joined{ latest < size && flags[part][latest - first] };
+					for (size_t point = first + 1; !joined && point < last; point++)
+					{
+						latest = size;
+						sequential.Push(point, TimeSeriesData::Time(point), TimeSeriesData::Value(point), Keep);
+						joined = latest < size && flags[part][latest - first];
 					}
+
+					if (joined)
+						std::copy(kept.begin(), kept.begin() + (latest - first) + 1, flags[part].begin());
 					else
 					{
-						StoreTime(t1->t());
-						t1++;
+						if (last < size)
+							sequential.Push(last, TimeSeriesData::Time(last), TimeSeriesData::Value(last), Keep);
+						else
+							sequential.Finish(Keep);
+						flags[part].swap(kept);
+						compressors[part] = sequential;
+						overflows[part].swap(overflow);
 					}
 				}
-				else if (t2 != ExtData.end())
-				{
-					StoreTime(t2->t());
-					t2++;
-				}
-				else
-					break;
 
+				// the kept points are moved to the beginnings of the parts in parallel
+				// and then the parts are joined
+				std::vector<size_t> counts(parts);
+				ThreadPool::Default().ParallelFor(parts, [&](size_t part)
+					{
+						const size_t first{ First(part) };
+						size_t kept{ first };
+						for (size_t point = 0; point < flags[part].size(); point++)
+							if (flags[part][point])
+								Storage::Set(kept++, TimeSeriesData::Time(first + point), TimeSeriesData::Value(first + point));
+						counts[part] = kept - first;
+					});
+				size_t kept{ counts[0] };
+				for (size_t part = 1; part < parts; part++)
+					for (size_t point = First(part); point < First(part) + counts[part]; point++)
+						Storage::Set(kept++, TimeSeriesData::Time(point), TimeSeriesData::Value(point));
+				Storage::resize(kept);
 			}
-			return uniontime;
 		}
 
-		TimeSeriesData& Aggregate(const T& Time, const Options& options)
-		{
-			if (options.MultiValuePoint() == MultiValuePointProcess::All || TimeSeriesData::size() < 2)
-				return *this;
-
-			// if there are points and we must aggregate them - caclualte 
-			// aggregate and replace points to single value
-
-			double MultiValue{ 0 };
-
-			for (auto TimePoint = TimeSeriesData::begin(); TimePoint != TimeSeriesData::end(); TimePoint++)
-			{
-				switch (options.MultiValuePoint())
-				{
-				case MultiValuePointProcess::Max:
-					MultiValue = TimePoint == TimeSeriesData::begin() ? TimePoint->v() : (std::max)(TimePoint->v(), MultiValue);
-					break;
-				case MultiValuePointProcess::Min:
-					MultiValue = TimePoint == TimeSeriesData::begin() ? TimePoint->v() : (std::min)(TimePoint->v(), MultiValue);
-					break;
-				case MultiValuePointProcess::Avg:
-					MultiValue += TimePoint->v();
-					break;
-				}
-			}
-
-			const double PointsCount{ static_cast<const double>(TimeSeriesData::size()) };
-			TimeSeriesData::clear();
-
-			switch (options.MultiValuePoint())
-			{
-			case MultiValuePointProcess::Min:
-			case MultiValuePointProcess::Max:
-				TimeSeriesData::emplace_back(Time, MultiValue);
-				break;
-			case MultiValuePointProcess::Avg:
-				TimeSeriesData::emplace_back(Time, MultiValue / PointsCount);
-				break;
-			}
-
-			return *this;
-		}
 	public:
 
 		static constexpr const char* TimeSeriesDoNotMatch = "Times and Values sizes do not match: Times {} and Values {}";
@@ -277,190 +1821,102 @@ namespace timeseries
 				TimeSeriesData::emplace_back(t, *v++);
 		}
 
+		// copies the columns or, for the view storage, refers to them
 		TimeSeriesData(size_t Size, const T* Times, const V* Values)
 		{
-			for (auto pT{ Times }; pT < Times + Size; pT++)
-				TimeSeriesData::emplace_back(*pT, *Values++);
+			if constexpr (std::is_same_v<Storage, TimeSeriesViewT<T, V>>)
+				static_cast<Storage&>(*this) = Storage(Size, Times, Values);
+			else
+				for (auto pT{ Times }; pT < Times + Size; pT++)
+					TimeSeriesData::emplace_back(*pT, *Values++);
 		}
 
+		// takes prepared storage, for example uniform grid
+		explicit TimeSeriesData(Storage&& Data) : Storage(std::move(Data)) {}
+
+		// loads CSV, binary or Gorilla series file. Mapped storage uses binary file in place
 		TimeSeriesData(const std::filesystem::path path)
 		{
-			std::ifstream csvfile(path);
-			if (csvfile.is_open())
+			if constexpr (MappedStorage)
+				static_cast<Storage&>(*this) = Storage(BinaryView<T, V>(path));
+			else if (BinaryView<T, V>::Is(path))
 			{
-				csvfile.imbue(std::locale(csvfile.getloc(), new comma_facet<char, ','>));
-				double time{ 0 }, value{ 0 };
-				char semicolon{ ';' };
-				for (;;)
-				{
-					csvfile >> time >> semicolon >> value;
-					if (csvfile.eof() || csvfile.fail())
-						break;
-					csvfile.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
-					TimeSeriesData::emplace_back(time, value);
-				}
+				const BinaryView<T, V> view(path);
+				TimeSeriesData::reserve(view.size());
+				for (size_t point = 0; point < view.size(); point++)
+					TimeSeriesData::emplace_back(view.Times()[point], view.Values()[point]);
 			}
+			else if (GorillaFile::Is(path))
+				GorillaFile::Read<T, V>(path,
+					[this](size_t size) { TimeSeriesData::reserve(size); },
+					[this](const T& time, const V& value) { TimeSeriesData::emplace_back(time, value); });
 			else
-				throw Exception("TimeSeries::TimeSeries - failed to open {}", path.string());
+				CSVReader(path).Read<T, V>([this](const T& time, const V& value)
+					{
+						TimeSeriesData::emplace_back(time, value);
+					});
 		}
 
-		class  CompareResult
+		// loads series in parallel if the options allow and validates the time order in
+		// parallel as well. Range, decimation and compression are applied by the sequential
+		// loader. Mapped storage can't be compressed on loading
+		TimeSeriesData(const std::filesystem::path path, const LoadOptions& options)
 		{
-		protected:
-
-			class MinMaxData : public pointT
-			{
-			protected:
-				V v1_ = {};
-				V v2_ = {};
-			public:
-				V v1() const { return v1_; }
-				V v2() const { return v2_; }
-				void v1(V v) { v1_ = v; }
-				void v2(V v) { v2_ = v; }
-			};
-			MinMaxData Max_, Min_;
-			V Sum_ = {};
-			V SqSum_ = {};
-			V Avg_ = {};
-			bool Reset_ = true;
-			bool Finished_ = false;
-			size_t Count_ = 0;
-			V KSDiffSum_ = {};	// Kolmogorov-Smirnov accumulator
-			V KSDiff_ = {};		// Kolmogorov-Smirnov max difference
-
-			inline static V AbsWeightedDifference(const V& v1, const V& v2, const Options& options)
-			{
-				return std::abs(CompareResult::WeightedDifference(v1, v2, options));
-			}
-
-			inline static V WeightedDifference(const V& v1, const V& v2, const Options& options)
-			{
-				return (v1 - v2) / (options.Rtol() * std::abs((std::max)(v1, v2)) + options.Atol());
-			}
-
-		public:
-			CompareResult()
-			{
-				Reset();
-			}
-
-			void Reset()
+			if constexpr (MappedStorage)
 			{
-				Count_ = {};
-				Finished_ = false;
-				Sum_ = {};
-				KSDiffSum_ = {};
-				KSDiff_ = {};
-				Avg_ = {};
-				SqSum_ = {};
+				if (options.Compress().has_value())
+					throw Exception("TimeSeriesData - mapped series can't be compressed on loading: {}", path.string());
+				LoadFiltered(path, options);
 			}
-
-			void Update(const TimeSeriesData& series1, const TimeSeriesData& series2, const Options& options)
+			else
 			{
-				for (auto pt1{ series1.begin() }, pt2{ series2.begin() }; pt1 != series1.end() && pt2 != series2.end(); pt1++, pt2++)
+				if (options.Compress().has_value())
 				{
-					const T diff{ pt1->v() - pt2->v() };
-
-					if (Reset_)
-					{
-						Reset_ = false;
-
-						Max_.t(pt1->t());
-						Max_.v(CompareResult::AbsWeightedDifference(pt1->v(), pt2->v(), options));
-						Max_.v1(pt1->v());
-						Max_.v2(pt2->v());
-
-						Min_.t(pt1->t());
-						Min_.v(CompareResult::AbsWeightedDifference(pt1->v(), pt2->v(), options));
-						Min_.v1(pt1->v());
-						Min_.v2(pt2->v());
-
-						KSDiffSum_ = diff;
-						KSDiff_ = std::abs(diff);
-
-					}
-					else
-					{
-						const auto awd { AbsWeightedDifference(pt1->v(), pt2->v(), options)};
-						if (std::abs(Max_.v()) < awd)
-						{
-							Max_.t(pt1->t());
-							Max_.v(awd);
-							Max_.v1(pt1->v());
-							Max_.v2(pt2->v());
-						}
-
-						if (std::abs(Min_.v()) > awd)
-						{
-							Min_.t(pt1->t());
-							Min_.v(awd);
-							Min_.v1(pt1->v());
-							Min_.v2(pt2->v());
-						}
-
-						KSDiffSum_ += diff;
-						const auto KSDiffSumAbs{ std::abs(KSDiffSum_) };
-						if (KSDiffSumAbs > KSDiff_)
-							KSDiff_ = KSDiffSumAbs;
-					}
-
-					Sum_ += diff;
-					SqSum_ += diff * diff;
-					Count_++;
+					LoadCompressed(path, options);
+					return;
 				}
-			}
-
 
-			CompareResult& Finish()
-			{
-				if (!Finished_)
+				if (options.Filtered())
 				{
-					if (Count_ > 0)
-						Avg_ = Sum_ / Count_;
-					Finished_ = true;
+					LoadFiltered(path, options);
+					return;
 				}
 
-				return *this;
-			}
-
-			bool Idenctical(const T& Tolerance = {}) const
-			{
-				return Max_.v() <= Tolerance;
-			}
-
-			const V KSTest() const 
-			{
-				return KSDiff_;
-			}
-
-			const MinMaxData Max() const
-			{
-				return Max_;
-			}
-
-			const MinMaxData Min() const
-			{
-				return Min_;
-			}
+				const auto threads{ options.Threads() == 0 ? ThreadPool::HardwareThreads() : options.Threads() };
+				if (threads == 1 || BinaryView<T, V>::Is(path) || GorillaFile::Is(path))
+				{
+					*this = TimeSeriesData(path);
+					return;
+				}
 
-			const T Avg() const
-			{
-				return Avg_;
-			}
+				const auto chunks{ CSVReader(path).ReadChunks<T, V>(threads) };
+				size_t size{ 0 };
+				for (const auto& chunk : chunks)
+					size += chunk.Times.size();
+				TimeSeriesData::reserve(size);
 
-			const T Sum() const
-			{
-				return Sum_;
-			}
+				// parsing stops on the first malformed record as in the sequential reader
+				for (const auto& chunk : chunks)
+				{
+					for (size_t point = 0; point < chunk.Times.size(); point++)
+						TimeSeriesData::emplace_back(chunk.Times[point], chunk.Values[point]);
+					if (!chunk.Complete)
+						break;
+				}
 
-			const T SqSum() const
-			{
-				return SqSum_;
+				// non-monotonic series is loaded, Check() will report it on use
+				Checked_ = !IsMonotonic(threads).has_value();
 			}
+		}
 
-
-		};
+		// loads value column Column from "time;c1;c2;...;cN" file with optional header
+		TimeSeriesData(const std::filesystem::path path, size_t Column)
+		{
+			CSVReader(path).ReadColumns<T, V>({ Column }, [this](const T& time, const V* values)
+				{
+					TimeSeriesData::emplace_back(time, *values);
+				});
+		}
 
 		NonMonotonicPairT IsMonotonic() const
 		{
@@ -468,16 +1924,41 @@ namespace timeseries
 			if (!TimeSeriesData::size())
 				return {};
 
-			auto TimePoint{ TimeSeriesData::begin() };
-			auto PrevTime{ TimePoint };
 			// check with no tolerance to
 			// lower_ upper_bound work properly
-			++TimePoint;
-			for (; TimePoint != TimeSeriesData::end(); TimePoint++)
-				if (PrevTime->t() > TimePoint->t())
-					return { {*PrevTime, *TimePoint} };
-				else
-					PrevTime = TimePoint;
+			for (size_t TimePoint = 1; TimePoint < TimeSeriesData::size(); TimePoint++)
+				if (TimeSeriesData::Time(TimePoint - 1) > TimeSeriesData::Time(TimePoint))
+					return { {(*this)[TimePoint - 1], (*this)[TimePoint]} };
+
+			return {};
+		}
+
+		// checks time order splitting series to Threads parts, 0 - all the cores
+		NonMonotonicPairT IsMonotonic(size_t Threads) const
+		{
+			if (Threads == 0)
+				Threads = ThreadPool::HardwareThreads();
+
+			const size_t size{ TimeSeriesData::size() };
+			if (Threads < 2 || size < 2 * Threads)
+				return IsMonotonic();
+
+			// first non monotonic point in each part
+			std::vector<size_t> found(Threads, size);
+			ThreadPool::Default().ParallelFor(Threads, [this, &found, size, Threads](size_t part)
+				{
+					const size_t last{ size * (part + 1) / Threads };
+					for (size_t TimePoint = (std::max)(size * part / Threads, static_cast<size_t>(1)); TimePoint < last; TimePoint++)
+						if (TimeSeriesData::Time(TimePoint - 1) > TimeSeriesData::Time(TimePoint))
+						{
+							found[part] = TimePoint;
+							break;
+						}
+				});
+
+			for (const auto TimePoint : found)
+				if (TimePoint < size)
+					return { {(*this)[TimePoint - 1], (*this)[TimePoint]} };
 
 			return {};
 		}
@@ -488,173 +1969,439 @@ namespace timeseries
 				std::cout << TimePoint.t() << ";" << TimePoint.v() << std::endl;
 		}
 
-		void WriteCSV(const std::filesystem::path& path)
+		// writes "time;value" file with the Decimal separator and Precision
+		// significant digits, by default the shortest exact form is used
+		void WriteCSV(const std::filesystem::path& path, char Decimal = ',', int Precision = CSVWriter::Shortest) const
 		{
-			std::ofstream csvfile(path);
-			if (csvfile.is_open())
-			{
-				csvfile.imbue(std::locale(csvfile.getloc(), new comma_facet<char, ','>));
-				for (const auto& TimePoint : *this)
-					csvfile << TimePoint.t() << ";" << TimePoint.v() << std::endl;
-			}
+			CSVWriter writer(path, Decimal, Precision);
+			for (size_t TimePoint = 0; TimePoint < TimeSeriesData::size(); TimePoint++)
+				writer.Write(TimeSeriesData::Time(TimePoint), TimeSeriesData::Value(TimePoint));
+			writer.Close();
+		}
+
+		// writes binary series file which can be loaded or mapped by the path constructor
+		void WriteBinary(const std::filesystem::path& path) const
+		{
+			timeseries::WriteBinary<T, V>(path, static_cast<const Storage&>(*this));
+		}
+
+		// writes lossless Gorilla-compressed series file which can be loaded by the path constructor
+		void WriteGorilla(const std::filesystem::path& path) const
+		{
+			GorillaFile::Write<T, V>(path, static_cast<const Storage&>(*this));
 		}
 
-		TimeSeriesData GetTimePoints(const T& Time, const Options& options) const
+		// points are returned in the point storage whatever the storage of the series is
+		TimeSeriesData<T, V> GetTimePoints(const T& Time, const Options& options) const
 		{
 			auto enddummy{ TimeSeriesData::end() };
 			return GetTimePoints(Time, options, enddummy);
 		}
 
-		TimeSeriesData GetTimePoints(const T& Time, const Options& options, fwitT& Start) const
+		TimeSeriesData<T, V> GetTimePoints(const T& Time, const Options& options, fwitT& Start) const
+		{
+			TimePointsT<T, V> points;
+			GetTimePoints(Time, options, Start, points);
+			TimeSeriesData<T, V> retdata;
+			retdata.reserve(points.size());
+			for (const auto& TimePoint : points)
+				retdata.emplace_back(TimePoint);
+			return retdata;
+		}
+
+		// points for the Time given read from the indexed CSV file. Only the blocks around
+		// the Time are parsed, the result is the same as the result for the whole series
+		static TimeSeriesData<T, V> GetTimePoints(const std::filesystem::path& path, const CSVIndexT<T, V>& Index, const T& Time, const Options& options)
+		{
+			const auto tolrange{ std::make_pair(Time - options.TimeTolerance(), Time + options.TimeTolerance()) };
+			// interpolation at the ends of the series needs two points
+			// before the tolerance range or two points after it
+			size_t after{ 0 };
+			TimeSeriesData<T, V> slice;
+			CSVReader(path).Read<T, V>([&tolrange, &after](const T& time)
+				{
+					if (after == 2)
+						return CSVRecord::Stop;
+					if (!(time < tolrange.second))
+						after++;
+					return CSVRecord::Take;
+				},
+				[&slice](const T& time, const V& value) { slice.emplace_back(time, value); },
+				Index.Seek(tolrange.first, 2));
+			return slice.GetTimePoints(Time, options);
+		}
+
+		// fills Points with the points for the Time given. Points
+		// are kept inline, so the common case does not allocate
+		template<size_t N>
+		TimePointsT<T, V, N>& GetTimePoints(const T& Time, const Options& options, fwitT& Start, TimePointsT<T, V, N>& Points) const
 		{
 			Check();
 
-			TimeSeriesData retdata;
+			Points.clear();
 
 			if (TimeSeriesData::empty())
-				return retdata;	// no output for empty series
-			else if (TimeSeriesData::size() == 1)
+				return Points;	// no output for empty series
+
+			// single point series outputs its point
+			TimeSlot slot{ 0, 1 };
+			const Storage& data{ *this };
+
+			if (TimeSeriesData::size() > 1)
 			{
-				// single point series outputs its point
-				retdata.emplace_back(TimeSeriesData::front().t(), TimeSeriesData::front().v());
-				return retdata;
+				const size_t start{ Start == TimeSeriesData::end() ? 0 : static_cast<size_t>(Start - TimeSeriesData::begin()) };
+
+				// select range for the bound search to left and right from the point requested
+				auto tolrange{ ToleranceRange(Time, options.TimeTolerance()) };
+				// get bounds by galloping from the start, search touches times only
+				const auto left{ GallopLowerBound(data, start, tolrange.first) };
+				const auto right{ GallopLowerBound(data, left, tolrange.second) };
+
+				// return iterator found for the bound to speedup next GetTimePoints call
+				Start = TimeSeriesData::begin() + left;
+				// if no points around time requested - slot is interpolated
+				// to time requested, otherwise its points are aggregated
+				slot = { left, right - left };
 			}
 
-			auto start { Start == TimeSeriesData::end() ? TimeSeriesData::begin() : Start};
-			const auto pred = [](const pointT& lhs, const pointT& rhs) -> bool
-			{
-				return lhs.t() < rhs.t();
-			};
+			const SlotPointsT<T, V> points(data, slot, Time, options, interpolation_);
+			for (size_t point = 0; point < points.size(); point++)
+				Points.emplace_back(points.t(data, point), points.v(data, point));
+
+			return Points;
+		}
+
+		template<typename ExtStorage, typename ExtInterpolation>
+		TimeSeriesData<T, V, typename ResultStorage<Storage>::type, Interpolation> Difference(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options) const
+		{
+			TimeSeriesData<T, V, typename ResultStorage<Storage>::type, Interpolation> ret;
+			ret.reserve((std::max)(TimeSeriesData::size(), ExtData.size()));
+			ForEachAligned(ExtData, options, [&ret](const T& time, const T&, const V& v1, const V& v2)
+				{
+					ret.emplace_back(time, v1 - v2);
+				});
+			return ret;
+		}
 
-			// select range for the bound search to left and right from the point requested
-			auto tolrange{ ToleranceRange(Time, options.TimeTolerance())};
-			const auto leftpoint{ pointT(tolrange.first, {}) };
-			const auto rightpoint{ pointT(tolrange.second, {}) };
-			// get bounds
-			auto left{ std::lower_bound(start, TimeSeriesData::end(), leftpoint, pred) };
-			auto right{ std::upper_bound(start, TimeSeriesData::end(), rightpoint, pred) };
+		template<typename ExtStorage, typename ExtInterpolation>
+		CompareResult Compare(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options) const
+		{
+			return Compare(ExtData, options, 1);
+		}
 
-			// return iterator found for the bound to speedup next GetTimePoints call
-			Start = left;
+		// compares the chunks of the series in Threads threads, 0 - all the cores. Results of
+		// the chunks are merged in order, so the result does not depend on the threads count
+		template<typename ExtStorage, typename ExtInterpolation>
+		CompareResult Compare(const TimeSeriesData<T, V, ExtStorage, ExtInterpolation>& ExtData, const Options& options, size_t Threads) const
+		{
+			if (Threads == 0)
+				Threads = ThreadPool::HardwareThreads();
 
-			// if there are points between bounds - send them to the output
-			for (auto it = left; it != right; it++)
-				if (it->t() >= tolrange.first && it->t() < tolrange.second)
-					retdata.emplace_back(*it);
+			// the series are checked and the interpolations are prepared before the threads
+			Check();
+			ExtData.Check();
 
-			// if no points around time requested - interpolate series
-			// to time requested
-			if (retdata.empty())
+			const auto chunks{ CompareChunks(ExtData, options) };
+			const size_t count{ chunks.size() - 1 };
+			const auto CompareChunk = [this, &ExtData, &options, &chunks](size_t chunk)
 			{
-				Interpolator<T, V> linear;
-				retdata.emplace_back(Time, linear.Get(*this, left, Time));
-			}
-			else
-				retdata.Aggregate(Time, options);
+				CompareResult comps;
+				ForEachAligned(ExtData, options, chunks[chunk], chunks[chunk + 1], [&comps, &options](const T&, const T& t1, const V& v1, const V& v2)
+					{
+						comps.Update(t1, v1, v2, options);
+					});
+				return comps.Finish();
+			};
 
-			/*
-			// debug dump
-			if (!retdata.empty())
+			CompareResult comps;
+			if (Threads < 2 || count < 2)
+				for (size_t chunk = 0; chunk < count; chunk++)
+					comps.Merge(CompareChunk(chunk));
+			else
 			{
-				std::cout << Time << " : ";
-				for (const auto& TimePoint : retdata)
-					std::cout << " { " << TimePoint.t() << " ; " << TimePoint.v() << " } ";
-				std::cout << std::endl;
+				// the threads take the chunks in turn
+				Threads = (std::min)(Threads, count);
+				std::vector<CompareResult> results(count);
+				ThreadPool::Default().ParallelFor(Threads, [&results, &CompareChunk, count, Threads](size_t thread)
+					{
+						for (size_t chunk = thread; chunk < count; chunk += Threads)
+							results[chunk] = CompareChunk(chunk);
+					});
+				for (const auto& result : results)
+					comps.Merge(result);
 			}
-			*/
-
-			return { retdata };
+			return comps.Finish();
 		}
 
-		TimeSeriesData Difference(const TimeSeriesData& ExtData, const Options& options) const
+		// compares the pairs of the series in Threads threads, 0 - all the cores. Pairs longer
+		// than the share of the thread are compared one by one by the chunks in parallel, the
+		// others are taken by the threads longest first and the short ones are coalesced to
+		// the tasks of about CompareResult::ChunkSize points. Result of each pair is exactly
+		// the result of Compare. Series of the pairs are derived from TimeSeriesData<T, V, ...>
+		template<typename Series1, typename Series2>
+		static std::vector<CompareResult> CompareBatch(const std::vector<std::pair<const Series1*, const Series2*>>& Pairs,
+			const Options& options, size_t Threads = 0)
 		{
-			const auto uniontime{ UnionTime(ExtData, options) };
-			TimeSeriesData ret;
-			ret.reserve(uniontime.size());
+			if (Threads == 0)
+				Threads = ThreadPool::HardwareThreads();
+
+			// series shared by the pairs are checked before the threads
+			std::vector<std::pair<size_t, size_t>> order;		// points and index of the pair
+			size_t total{ 0 };
+			order.reserve(Pairs.size());
+			for (size_t pair = 0; pair < Pairs.size(); pair++)
+			{
+				const auto& [series1, series2] { Pairs[pair] };
+				series1->Check();
+				series2->Check();
+				order.emplace_back(series1->size() + series2->size(), pair);
+				total += order.back().first;
+			}
+			std::sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs)
+				{
+					return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+				});
 
-			auto it1{ TimeSeriesData::end() };
-			auto it2{ ExtData.end() };
-			for (const auto& time : uniontime)
+			std::vector<CompareResult> results(Pairs.size());
+			const auto ComparePair = [&Pairs, &results, &options](size_t pair, size_t threads)
 			{
-				const auto series1{ GetTimePoints(time, options, it1) };
-				const auto series2{ ExtData.GetTimePoints(time, options, it2) };
+				results[pair] = Pairs[pair].first->Compare(*Pairs[pair].second, options, threads);
+			};
 
-				for (auto pt1{ series1.begin() }, pt2{ series2.begin() }; pt1 != series1.end() && pt2 != series2.end(); pt1++, pt2++)
-					ret.emplace_back(time, pt1->v() - pt2->v());
+			// tasks are the ranges of the ordered pairs
+			std::vector<std::pair<size_t, size_t>> tasks;
+			const size_t share{ total / Threads };
+			for (size_t first = 0; first < order.size();)
+			{
+				if (Threads > 1 && order[first].first > (std::max)(share, CompareResult::ChunkSize))
+				{
+					ComparePair(order[first++].second, Threads);
+					continue;
+				}
+				size_t last{ first + 1 }, points{ order[first].first };
+				while (last < order.size() && points + order[last].first <= CompareResult::ChunkSize)
+					points += order[last++].first;
+				tasks.emplace_back(first, last);
+				first = last;
 			}
-			return ret;
+
+			std::atomic<size_t> next{ 0 };
+			const auto Work = [&tasks, &order, &next, &ComparePair](size_t)
+			{
+				for (size_t task; (task = next.fetch_add(1)) < tasks.size();)
+					for (size_t pair = tasks[task].first; pair < tasks[task].second; pair++)
+						ComparePair(order[pair].second, 1);
+			};
+
+			if (Threads < 2 || tasks.size() < 2)
+				Work(0);
+			else
+				ThreadPool::Default().ParallelFor((std::min)(Threads, tasks.size()), Work);
+			return results;
 		}
 
-		CompareResult Compare(const TimeSeriesData<T,V>& ExtData, const Options& options) const
+		// drops the points which can be restored by the interpolation with the tolerances
+		// of options by the method of options. Returns the count of the points dropped
+		size_t Compress(const Options& options)
 		{
-			CompareResult comps;
-			auto it1{ TimeSeriesData::end() };
-			auto it2{ ExtData.end() };
-			for (const auto& time : UnionTime(ExtData, options))
-				comps.Update(GetTimePoints(time, options, it1), ExtData.GetTimePoints(time, options, it2), options);
-			return comps.Finish();
+			return Compress(options, 1);
 		}
 
-		size_t Compress(const Options& options)
+		// compresses the parts of the series in Threads threads, 0 - all the cores. The result
+		// is the same as the sequential one. Points and columns storages are compressed in place,
+		// uniform storage is rejected
+		size_t Compress(const Options& options, size_t Threads)
+		{
+			if constexpr (UniformStorage)
+				throw Exception("TimeSeriesData::Compress - uniform grid can't hold the compressed points, "
+					"output the series to the points or columns storage first");
+			const size_t originalsize{ TimeSeriesData::size() };
+			if (options.Compression() == CompressMethod::SwingingDoor)
+				CompressBy(SwingingDoorT<T, V>(options), Threads);
+			else
+				CompressBy(NeighbourCompressorT<T, V>(options), Threads);
+			// the order of the points is kept
+			interpolation_.Invalidate();
+			return originalsize - TimeSeriesData::size();
+		}
+
+		// outputs series to the storage given, uniform storage
+		// gets the grid of the output
+		// points of the series at Start + i * Step up to End computed on demand.
+		// The range refers to the series and must not outlive it
+		class DenseRange
 		{
-			size_t originalsize{ TimeSeriesData::size() };
-			TimeSeriesData compressed;
-			compressed.reserve(originalsize);
-			auto it{ TimeSeriesData::begin() };
-			if (it != TimeSeriesData::end())
+		protected:
+			const TimeSeriesData* data_;
+			T Start_, End_, Step_;
+			Options options_;
+		public:
+			class const_iterator
 			{
-				compressed.emplace_back(*it);
-				it++;
-				const auto tolt{ 2.0 * options.TimeTolerance() };
-				for (; it != TimeSeriesData::end(); it++)
+			protected:
+				const DenseRange* range_ = nullptr;		// nullptr for the end of the range
+				fwitT start_;
+				TimePointsT<T, V> points_;
+				ptrdiff_t step_ = 0;
+				size_t point_ = 0;
+				T time_ = {};
+
+				// finds the next step with points
+				void Seek()
 				{
-					const auto prev{ compressed.back() };
-					if (std::abs(prev.t() - it->t()) < tolt && std::abs(prev.v() - it->v()) < options.ValueTolerance())
-						continue;
-
-					const auto next{ std::next(it) };
-					if (next != TimeSeriesData::end())
+					for (; ; step_++)
 					{
-						auto denom{ next->t() - prev.t() };
-						if (std::abs(denom) > 0.0)
+						time_ = range_->Start_ + static_cast<T>(step_) * range_->Step_;
+						if (time_ > range_->End_)
 						{
-							denom = (next->v() - prev.v()) / denom * (it->t() - prev.t()) + prev.v();
-							if (std::abs(it->v() - denom) < options.ValueTolerance())
-								continue;
+							range_ = nullptr;
+							return;
 						}
-						else
-							continue;
+						if (!range_->data_->GetTimePoints(time_, range_->options_, start_, points_).empty())
+						{
+							point_ = 0;
+							return;
+						}
+					}
+				}
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = PointT<T, V>;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const PointT<T, V>*;
+				using reference = PointT<T, V>;
+
+				const_iterator() = default;
+				explicit const_iterator(const DenseRange* Range) : range_{ Range }, start_{ Range->data_->end() }
+				{
+					Seek();
+				}
+
+				reference operator*() const { return { time_, points_[point_].v() }; }
+
+				const_iterator& operator++()
+				{
+					if (++point_ == points_.size())
+					{
+						step_++;
+						Seek();
 					}
-					compressed.emplace_back(*it);
+					return *this;
+				}
+
+				bool operator==(const const_iterator& rhs) const
+				{
+					return range_ == rhs.range_ && (range_ == nullptr || (step_ == rhs.step_ && point_ == rhs.point_));
 				}
+				bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+			};
+			using iterator = const_iterator;
+
+			DenseRange(const TimeSeriesData& Data, const T& Start, const T& End, const T& Step, const Options& options) :
+				data_{ &Data }, Start_{ Start }, End_{ End }, Step_{ Step }, options_{ options } {}
+
+			const_iterator begin() const { return const_iterator(this); }
+			const_iterator end() const { return {}; }
+
+			// feeds the points to the Sink.Write(time, value) one by one
+			template<typename Sink>
+			Sink& WriteTo(Sink& sink) const
+			{
+				for (const auto& point : *this)
+					sink.Write(point.t(), point.v());
+				return sink;
 			}
-			TimeSeriesData::swap(compressed);
-			return originalsize - TimeSeriesData::size();
+		};
+
+		// compares the points written with the series at the times of the points. Extra points
+		// with the same time are paired with the points of the series in order, as in Compare.
+		// The sink refers to the series and must not outlive it
+		class CompareSink
+		{
+		protected:
+			const TimeSeriesData& data_;
+			Options options_;
+			fwitT start_;
+			TimePointsT<T, V> points_;
+			CompareResult result_;
+			std::optional<T> time_;
+			size_t point_ = 0;
+		public:
+			CompareSink(const TimeSeriesData& Data, const Options& options) : data_{ Data }, options_{ options }, start_{ Data.end() } {}
+
+			void Write(const T& Time, const V& Value)
+			{
+				if (time_ != Time)
+				{
+					time_ = Time;
+					point_ = 0;
+					data_.GetTimePoints(Time, options_, start_, points_);
+				}
+				if (point_ < points_.size())
+					result_.Update(Time, Value, points_[point_++].v(), options_);
+			}
+
+			CompareResult& Result() { return result_.Finish(); }
+		};
+
+		// lazy form of DenseOutput for the output which does not fit the memory
+		DenseRange DenseOutputRange(const T& Start, const T& End, const T& Step, const Options& options) const
+		{
+			return DenseRange(*this, Start, End, Step, options);
 		}
 
-		TimeSeriesData DenseOutput(const T& Start, const T& End, const T& Step, const Options& options) const
+		// evaluates the series at Count ascending Times to Values by the single merge sweep.
+		// Multivalue points give one value as EvaluationBlockT says
+		void Evaluate(const T* Times, size_t Count, V* Values, const Options& options) const
 		{
-			TimeSeriesData dense;
-			auto start{ TimeSeriesData::end() };
-			ptrdiff_t ti{ 0 };
-			for (; ; ti++)
+			Check();
+			const Storage& data{ *this };
+			TimeCursor<T, Storage> cursor(data);
+			EvaluationBlockT<T, V> block(options);
+			for (size_t time = 0; time < Count;)
 			{
-				const T t{ Start + static_cast<T>(ti) * Step };
-				if (t > End)
-					break;
+				// the first time of the block is checked against the last time of the previous block
+				if (time > 0 && Times[time] < Times[time - 1])
+					throw Exception("TimeSeriesData::Evaluate - times are not ascending : [{}] > [{}]", Times[time - 1], Times[time]);
+				const auto swept{ block.Sweep(data, cursor, Times + time, Count - time) };
+				block.Apply(data, Values + time, interpolation_);
+				time += swept;
+			}
+		}
+
+		std::vector<V> Evaluate(const std::vector<T>& Times, const Options& options) const
+		{
+			std::vector<V> values(Times.size());
+			Evaluate(Times.data(), Times.size(), values.data(), options);
+			return values;
+		}
 
-				for (const auto& TimePoint : GetTimePoints(t, options, start))
-					dense.emplace_back(t, TimePoint.v());
+		// the uniform grid holds one value per step, so multivalue points must be
+		// reduced by MultiValuePointProcess other than All for the uniform output
+		template<typename DenseStorage = typename ResultStorage<Storage>::type>
+		TimeSeriesData<T, V, DenseStorage, Interpolation> DenseOutput(const T& Start, const T& End, const T& Step, const Options& options) const
+		{
+			TimeSeriesData<T, V, DenseStorage, Interpolation> dense;
+			constexpr bool uniform{ std::is_same_v<DenseStorage, TimeSeriesUniformT<T, V>> };
+			if constexpr (uniform)
+				dense = TimeSeriesData<T, V, DenseStorage, Interpolation>(DenseStorage(Start, Step));
+			for (const auto& point : DenseOutputRange(Start, End, Step, options))
+			{
+				if constexpr (uniform)
+					if (!dense.empty() && dense.back().t() == point.t())
+						throw Exception("TimeSeriesData::DenseOutput - multivalue point at t={} does not fit the uniform grid, "
+							"set MultiValuePointProcess other than All", point.t());
+				dense.emplace_back(point.t(), point.v());
 			}
 			return dense;
 		}
 	};
 
-	template<typename T, typename V>
-	class TimeSeries : public TimeSeriesData<T, V>
+	template<typename T, typename V, typename Storage = TimeSeriesDataT<T, V>, typename Interpolation = LinearInterpolationT<T, V>>
+	class TimeSeries : public TimeSeriesData<T, V, Storage, Interpolation>
 	{
 		friend class timeseries_test::TimeSeriesTests;
 	public:
-		using TimeSeriesData<T, V>::TimeSeriesData;
+		using TimeSeriesData<T, V, Storage, Interpolation>::TimeSeriesData;
 	};
 }
\ No newline at end of file